@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    AllpassDiffuser.cpp
+    A chain of Schroeder allpass stages that smears transients into a wash.
+
+  ==============================================================================
+*/
+
+#include "AllpassDiffuser.h"
+
+//==============================================================================
+namespace
+{
+    // Stage delays in milliseconds, spread out and not multiples of each other
+    // so the stages don't reinforce the same echoes
+    constexpr float stageMilliseconds[AllpassDiffuser::maxStages] = { 4.77f, 3.59f, 12.73f, 9.31f, 1.73f, 7.07f, 2.53f, 5.37f };
+}
+
+void AllpassDiffuser::prepare (double sampleRate)
+{
+    for (int stage = 0; stage < maxStages; ++stage)
+        lengths[(size_t) stage] = juce::jmax (4, juce::roundToInt (stageMilliseconds[stage] * 0.001 * sampleRate));
+
+    auto longest = *std::max_element (lengths.begin(), lengths.end());
+    ringCapacity = (longest + floatsPerCacheLine - 1) / floatsPerCacheLine * floatsPerCacheLine;
+
+    // One block for every ring, with enough slack to start it on a cache line
+    memory.assign ((size_t) (ringCapacity * maxStages * maxChannels + floatsPerCacheLine), 0.0f);
+    auto address = reinterpret_cast<std::uintptr_t> (memory.data());
+    auto alignment = (std::uintptr_t) floatsPerCacheLine * sizeof (float);
+    rings = memory.data() + ((alignment - address % alignment) % alignment) / sizeof (float);
+
+    reset();
+}
+
+void AllpassDiffuser::reset()
+{
+    std::fill (memory.begin(), memory.end(), 0.0f);
+    positions.fill (0);
+}
+
+void AllpassDiffuser::setParameters (int numStages, float allpassGain)
+{
+    stages = juce::jlimit (1, maxStages, numStages);
+    gain = juce::jlimit (-0.95f, 0.95f, allpassGain);
+}
+
+void AllpassDiffuser::processFrame (float* frame, int numChannels) noexcept
+{
+    if (rings == nullptr)
+        return;
+
+    for (int stage = 0; stage < stages; ++stage)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* ring = getRing (stage, channel);
+            auto& position = positions[(size_t) (stage * maxChannels + channel)];
+
+            // v[n] = x[n] + g v[n-D], y[n] = v[n-D] - g v[n]
+            auto delayed = ring[position];
+            auto v = frame[channel] + gain * delayed;
+            ring[position] = v;
+            frame[channel] = delayed - gain * v;
+
+            if (++position >= lengths[(size_t) stage])
+                position = 0;
+        }
+    }
+}
+
+void AllpassDiffuser::processChannels (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (rings == nullptr)
+        return;
+
+    auto g = Float4::broadcast (gain);
+
+    for (int stage = 0; stage < stages; ++stage)
+    {
+        int length = lengths[(size_t) stage];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* ring = getRing (stage, channel);
+            auto* data = channels[channel];
+            auto& position = positions[(size_t) (stage * maxChannels + channel)];
+
+            for (int i = 0; i < numSamples;)
+            {
+                // Up to the end of the ring; the ring is the delay length, so
+                // nothing read here was written in the same run
+                int run = juce::jmin (numSamples - i, length - position);
+                auto* delayed = ring + position;
+                int j = 0;
+
+                for (; j + 4 <= run; j += 4)
+                {
+                    auto d = Float4::load (delayed + j);
+                    auto v = Float4::multiplyAdd (Float4::load (data + i + j), g, d);
+                    v.store (delayed + j);
+                    (d - g * v).store (data + i + j);
+                }
+
+                for (; j < run; ++j)
+                {
+                    auto d = delayed[j];
+                    auto v = data[i + j] + gain * d;
+                    delayed[j] = v;
+                    data[i + j] = d - gain * v;
+                }
+
+                i += run;
+                position += run;
+
+                if (position >= length)
+                    position = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    AllpassDiffuser.h
+    A chain of Schroeder allpass stages that smears transients into a wash.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    Up to eight Schroeder allpass stages in series. Each stage keeps a short
+    ring per channel, and all the rings are packed into one block of memory
+    with every ring starting on a cache line.
+
+    Blocks are processed stage by stage. A stage's ring is exactly as long as
+    its delay, so the four samples ahead of the write position are always
+    already there, and the recursion runs four samples at a time.
+*/
+class AllpassDiffuser
+{
+public:
+    static constexpr int maxStages = 8;
+    static constexpr int maxChannels = 4;
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Sets how many stages run (clamped to 1 to maxStages) and the allpass
+        gain of every stage.
+    */
+    void setParameters (int numStages, float allpassGain);
+
+    /** Diffuses one frame in place. The frame must hold maxChannels floats. */
+    void processFrame (float* frame, int numChannels) noexcept;
+
+    /** Diffuses a block of separate channel buffers in place. */
+    void processChannels (float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    float* getRing (int stage, int channel) noexcept     { return rings + (stage * maxChannels + channel) * ringCapacity; }
+
+    static constexpr int floatsPerCacheLine = 16;
+
+    std::vector<float> memory;
+    float* rings = nullptr;
+    int ringCapacity = 0;
+
+    std::array<int, maxStages> lengths {};
+    std::array<int, maxStages * maxChannels> positions {};
+    int stages = 4;
+    float gain = 0.5f;
+};
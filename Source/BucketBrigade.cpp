@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    BucketBrigade.cpp
+    Bucket-brigade delay whose clock follows the delay time.
+
+  ==============================================================================
+*/
+
+#include "BucketBrigade.h"
+#include "FeedbackSaturator.h"
+
+//==============================================================================
+void BucketBrigade::prepare (double newSampleRate)
+{
+    // Keep the buckets full across a re-prepare at the same rate
+    if (newSampleRate == sampleRate && ! ring.empty())
+        return;
+
+    sampleRate = newSampleRate;
+
+    // Cut off at 0.45 of the clock rate, just short of its Nyquist
+    if (kernels == nullptr)
+        kernels = WindowedSincTable::getShared (numTaps, numPhases);
+
+    ring.assign ((size_t) ((ringFrames + numTaps) * maxChannels), 0.0f);
+
+    // Delay changes bend the pitch like the real clock sweeping, over about 50 ms
+    glideCoefficient = 1.0f - std::exp (-1.0f / (0.05f * (float) sampleRate));
+    clockRatio = targetClockRatio;
+    reset();
+}
+
+void BucketBrigade::reset()
+{
+    std::fill (ring.begin(), ring.end(), 0.0f);
+    writePosition = 0;
+    clockPhase = 0.0f;
+    lowpass1 = lowpass2 = previousLowpass = lastOutput = Float4::broadcast (0.0f);
+}
+
+void BucketBrigade::setParameters (float delayInSamples, float feedback)
+{
+    // One clock tick moves the signal one stage along
+    targetClockRatio = (float) numStages / juce::jmax ((float) numStages, delayInSamples);
+    feedbackGain = juce::jlimit (0.0f, 0.99f, feedback);
+}
+
+void BucketBrigade::writeStage (Float4 frame) noexcept
+{
+    auto* data = ring.data();
+    frame.store (data + writePosition * maxChannels);
+
+    if (writePosition < numTaps)
+        frame.store (data + (writePosition + ringFrames) * maxChannels);
+
+    if (++writePosition >= ringFrames)
+        writePosition = 0;
+}
+
+void BucketBrigade::process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept
+{
+    if (ring.empty())
+        return;
+
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    // The anti-aliasing filter is set for the clock rate this block glides
+    // towards; two one-poles at 0.4 of the clock rate
+    auto cutoff = juce::jmin (0.45f, 0.4f * targetClockRatio);
+    auto coefficient = Float4::broadcast (1.0f - std::exp (-juce::MathConstants<float>::twoPi * cutoff));
+    auto feedback = Float4::broadcast (feedbackGain);
+    auto* data = ring.data();
+
+    alignas (16) float frame[maxChannels] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = input[channel][i];
+
+        // The stages only hold so much, so the loop clips softly
+        auto x = FeedbackSaturator::fastTanh (Float4::multiplyAdd (Float4::load (frame), lastOutput, feedback));
+        lowpass1 = Float4::multiplyAdd (lowpass1, x - lowpass1, coefficient);
+        lowpass2 = Float4::multiplyAdd (lowpass2, lowpass1 - lowpass2, coefficient);
+
+        clockRatio += (targetClockRatio - clockRatio) * glideCoefficient;
+        clockPhase += clockRatio;
+
+        if (clockPhase >= 1.0f)
+        {
+            // The tick fell between the last host sample and this one; sample
+            // the filtered input at that point
+            clockPhase -= 1.0f;
+            auto ticksAgo = Float4::broadcast (clockPhase / clockRatio);
+            writeStage (Float4::multiplyAdd (lowpass2, previousLowpass - lowpass2, ticksAgo));
+        }
+
+        previousLowpass = lowpass2;
+
+        // Read numStages ticks back from now, clockPhase ticks past the last
+        // stage written. The kernel's taps are one tick apart.
+        auto start = writePosition - numStages - numTaps / 2;
+
+        if (start < 0)
+            start += ringFrames;
+
+        const auto* kernel = kernels->getKernel (clockPhase);
+        const auto* taps = data + start * maxChannels;
+        auto sum = Float4::broadcast (0.0f);
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            sum = Float4::multiplyAdd (sum, Float4::load (taps + tap * maxChannels), Float4::broadcast (kernel[tap]));
+
+        lastOutput = sum;
+        sum.store (frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            output[channel][i] = frame[channel];
+    }
+}
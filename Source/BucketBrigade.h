@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    BucketBrigade.h
+    Bucket-brigade delay whose clock follows the delay time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+#include "WindowedSincTable.h"
+
+//==============================================================================
+/**
+    A fixed number of stages clocked at whatever rate gives the delay time, so
+    long delays run the clock slowly and lose bandwidth the way the analog
+    chips do.
+
+    The input is low-passed just below the clock's Nyquist and sampled into
+    the stages on each clock tick. The output is read back at the host rate
+    through a shared polyphase windowed-sinc table, with the kernel taps
+    spaced by clock ticks, so the anti-imaging filter always follows the
+    clock. The clock never runs faster than the host, so a host sample costs
+    at most one stage write and one eight-tap read, whatever the delay.
+
+    All channels share one interleaved stage ring, so one Float4 covers a
+    tick for every channel.
+*/
+class BucketBrigade
+{
+public:
+    static constexpr int maxChannels = 4;
+    static constexpr int numStages = 1024;
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Sets the delay in host samples and the feedback gain. The clock can't
+        run faster than the host, so delays shorter than numStages samples
+        are lengthened to that.
+    */
+    void setParameters (float delayInSamples, float feedback);
+
+    void process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+private:
+    static constexpr int numTaps = 8;
+    static constexpr int numPhases = 256;
+
+    // The ring holds numStages ticks plus one kernel, and its first numTaps
+    // frames are mirrored past the end so every kernel is one contiguous run
+    static constexpr int ringFrames = numStages + numTaps;
+
+    void writeStage (Float4 frame) noexcept;
+
+    std::shared_ptr<const WindowedSincTable> kernels;
+    std::vector<float> ring;
+    int writePosition = 0;
+
+    float clockRatio = 1.0f, targetClockRatio = 1.0f;
+    float clockPhase = 0.0f;
+    float glideCoefficient = 0.0f;
+    float feedbackGain = 0.0f;
+
+    Float4 lowpass1 = Float4::broadcast (0.0f), lowpass2 = Float4::broadcast (0.0f);
+    Float4 previousLowpass = Float4::broadcast (0.0f);
+    Float4 lastOutput = Float4::broadcast (0.0f);
+    double sampleRate = 44100.0;
+};
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    CombResonator.cpp
+    Karplus-Strong style tuned comb for loops down to a few samples.
+
+  ==============================================================================
+*/
+
+#include "CombResonator.h"
+
+//==============================================================================
+void CombResonator::prepare (double newSampleRate)
+{
+    // Let strings that are still ringing carry on if the rate is unchanged
+    if (newSampleRate == sampleRate && ! ring.empty())
+        return;
+
+    sampleRate = newSampleRate;
+
+    // A power of two, so wrapping is a mask
+    auto longest = (int) std::ceil (sampleRate / minFrequency) + 4;
+    auto size = (int) juce::nextPowerOfTwo (longest);
+
+    ring.assign ((size_t) (size * maxChannels), 0.0f);
+    ringMask = size - 1;
+    currentFrequency = currentDecay = currentDamping = -1.0f;
+    reset();
+}
+
+void CombResonator::reset()
+{
+    std::fill (ring.begin(), ring.end(), 0.0f);
+    writePosition = 0;
+    previousInput = previousOutput = Float4::broadcast (0.0f);
+}
+
+void CombResonator::setParameters (float frequencyHz, float decaySeconds, float damping)
+{
+    if (frequencyHz == currentFrequency && decaySeconds == currentDecay && damping == currentDamping)
+        return;
+
+    currentFrequency = frequencyHz;
+    currentDecay = decaySeconds;
+    currentDamping = damping;
+    updateLoop();
+}
+
+void CombResonator::updateLoop()
+{
+    auto period = juce::jlimit (minLoopSamples, (float) (ringMask - 2), (float) (sampleRate / juce::jmax (minFrequency, currentFrequency)));
+
+    // The damping filter averages two neighbouring samples, which delays the
+    // loop by up to half a sample; the rest is split between the integer
+    // delay and an allpass kept between 0.1 and 1.1 samples, where its
+    // coefficient stays well away from the unstable end
+    dampingAmount = 0.5f * juce::jlimit (0.0f, 1.0f, currentDamping);
+    auto remaining = period - dampingAmount;
+    integerDelay = juce::jmax (1, (int) std::floor (remaining - 0.1f));
+    auto fraction = remaining - (float) integerDelay;
+    allpassCoefficient = (1.0f - fraction) / (1.0f + fraction);
+
+    // Every pass through the loop loses the same share, so the whole tone
+    // fades by 60 dB over decaySeconds
+    loopGain = (float) std::pow (10.0, -3.0 * period / (juce::jmax (0.01f, currentDecay) * sampleRate));
+}
+
+void CombResonator::process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    auto* data = ring.data();
+    auto mask = ringMask;
+    auto position = writePosition;
+    auto delay = integerDelay;
+    auto coefficient = Float4::broadcast (allpassCoefficient);
+    auto damping = Float4::broadcast (dampingAmount);
+    auto gain = Float4::broadcast (loopGain);
+    auto apInput = previousInput;
+    auto apOutput = previousOutput;
+
+    alignas (16) float frame[maxChannels] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = input[channel][i];
+
+        auto newest = Float4::load (data + ((position - delay) & mask) * maxChannels);
+        auto older = Float4::load (data + ((position - delay - 1) & mask) * maxChannels);
+        auto damped = Float4::multiplyAdd (newest, older - newest, damping);
+
+        // y[n] = a (x[n] - y[n-1]) + x[n-1]
+        auto tuned = Float4::multiplyAdd (apInput, coefficient, damped - apOutput);
+        apInput = damped;
+        apOutput = tuned;
+
+        auto loopOutput = tuned * gain;
+        (Float4::load (frame) + loopOutput).store (data + position * maxChannels);
+        position = (position + 1) & mask;
+
+        loopOutput.store (frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            output[channel][i] = frame[channel];
+    }
+
+    writePosition = position;
+    previousInput = apInput;
+    previousOutput = apOutput;
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    CombResonator.h
+    Karplus-Strong style tuned comb for loops down to a few samples.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    A feedback comb tuned to a pitch. The loop is an integer delay, a two-point
+    damping filter and a first-order allpass that supplies the fractional part
+    of the period, so the tuning is exact without interpolating the read.
+
+    Loops can be much shorter than a block, so the recursion runs one sample at
+    a time. To keep that cheap, the ring holds every channel of a sample side
+    by side: one Float4 load, filter and store per sample serves all channels.
+    The loop length and filter state live in locals for the whole run.
+*/
+class CombResonator
+{
+public:
+    static constexpr int maxChannels = 4;
+    static constexpr float minLoopSamples = 4.0f;
+    static constexpr float minFrequency = 20.0f;
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Damping runs from 0 (bright) to 1 (dull). Only recomputes on a change. */
+    void setParameters (float frequencyHz, float decaySeconds, float damping);
+
+    /** Writes the resonator output for input into output. They may be the same
+        buffers.
+    */
+    void process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+private:
+    void updateLoop();
+
+    std::vector<float> ring;
+    int ringMask = 0;
+    int writePosition = 0;
+
+    int integerDelay = 1;
+    float allpassCoefficient = 0.0f;
+    float dampingAmount = 0.0f;
+    float loopGain = 0.0f;
+
+    Float4 previousInput = Float4::broadcast (0.0f), previousOutput = Float4::broadcast (0.0f);
+
+    double sampleRate = 44100.0;
+    float currentFrequency = -1.0f, currentDecay = -1.0f, currentDamping = -1.0f;
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.cpp
+    Peak or RMS level detection with attack and release, over whole blocks.
+
+  ==============================================================================
+*/
+
+#include "EnvelopeFollower.h"
+
+//==============================================================================
+void EnvelopeFollower::prepare (double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+    detectorBuffer.resize ((size_t) maximumBlockSize);
+    currentAttack = currentRelease = -1.0f;
+    reset();
+}
+
+void EnvelopeFollower::reset()
+{
+    state = 0.0f;
+}
+
+float EnvelopeFollower::coefficientFor (float milliseconds) const
+{
+    return (float) std::exp (-1.0 / (juce::jmax (0.01, (double) milliseconds) * 0.001 * sampleRate));
+}
+
+void EnvelopeFollower::setParameters (Detector detector, float attackMs, float releaseMs)
+{
+    if (detector != currentDetector)
+    {
+        // Peak and RMS states aren't on the same scale
+        currentDetector = detector;
+        reset();
+    }
+
+    if (attackMs != currentAttack)
+    {
+        currentAttack = attackMs;
+        attackCoefficient = coefficientFor (attackMs);
+    }
+
+    if (releaseMs != currentRelease)
+    {
+        currentRelease = releaseMs;
+        releaseCoefficient = coefficientFor (releaseMs);
+    }
+}
+
+void EnvelopeFollower::process (const float* const* channels, int numChannels, float* envelope, int numSamples) noexcept
+{
+    jassert (numSamples <= (int) detectorBuffer.size());
+    auto* detector = detectorBuffer.data();
+
+    if (numChannels <= 0)
+    {
+        juce::FloatVectorOperations::clear (envelope, numSamples);
+        return;
+    }
+
+    if (currentDetector == Detector::peak)
+    {
+        juce::FloatVectorOperations::abs (detector, channels[0], numSamples);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+        {
+            juce::FloatVectorOperations::abs (envelope, channels[channel], numSamples);
+            juce::FloatVectorOperations::max (detector, detector, envelope, numSamples);
+        }
+    }
+    else
+    {
+        juce::FloatVectorOperations::multiply (detector, channels[0], channels[0], numSamples);
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply (detector, channels[channel], channels[channel], numSamples);
+
+        juce::FloatVectorOperations::multiply (detector, 1.0f / (float) numChannels, numSamples);
+    }
+
+    // The ballistics are a recursion, so this part stays sample by sample
+    auto level = state;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto input = detector[i];
+        auto coefficient = input > level ? attackCoefficient : releaseCoefficient;
+        level = input + (level - input) * coefficient;
+        envelope[i] = level;
+    }
+
+    state = level;
+
+    if (currentDetector == Detector::rms)
+        for (int i = 0; i < numSamples; ++i)
+            envelope[i] = std::sqrt (envelope[i]);
+}
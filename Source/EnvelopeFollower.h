@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    EnvelopeFollower.h
+    Peak or RMS level detection with attack and release, over whole blocks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Follows the level of a group of channels. The detector input (the loudest
+    channel's magnitude, or the mean square across channels) is built for the
+    whole block with vector operations, then a one-pole with separate attack
+    and release coefficients runs over it.
+
+    The coefficients are only recomputed when a time actually changes.
+*/
+class EnvelopeFollower
+{
+public:
+    enum class Detector
+    {
+        peak = 0,
+        rms
+    };
+
+    void prepare (double sampleRate, int maximumBlockSize);
+    void reset();
+
+    void setParameters (Detector detector, float attackMs, float releaseMs);
+
+    /** Writes the linear envelope of the channels into envelope. */
+    void process (const float* const* channels, int numChannels, float* envelope, int numSamples) noexcept;
+
+private:
+    float coefficientFor (float milliseconds) const;
+
+    std::vector<float> detectorBuffer;
+    double sampleRate = 44100.0;
+    Detector currentDetector = Detector::peak;
+    float currentAttack = -1.0f, currentRelease = -1.0f;
+    float attackCoefficient = 0.0f, releaseCoefficient = 0.0f;
+    float state = 0.0f;
+};
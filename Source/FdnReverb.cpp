@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    FdnReverb.cpp
+    Feedback delay network reverb with a Hadamard feedback matrix.
+
+  ==============================================================================
+*/
+
+#include "FdnReverb.h"
+
+//==============================================================================
+void FdnReverb::prepare (double newSampleRate)
+{
+    // Many hosts re-prepare on every transport start, which shouldn't cut
+    // the tail off
+    if (newSampleRate == sampleRate && ! arena.empty())
+        return;
+
+    sampleRate = newSampleRate;
+
+    // Room for the longest line plus the gap to the primes above it, kept a
+    // multiple of four floats so every line starts on a 16 byte boundary
+    lineCapacity = ((int) std::ceil (longestLineSeconds * sampleRate) + 256 + 3) & ~3;
+    arena.assign ((size_t) (lineCapacity * maxLines), 0.0f);
+
+    currentSize = currentDecay = currentDamping = -1.0f;
+    reset();
+}
+
+void FdnReverb::reset()
+{
+    std::fill (arena.begin(), arena.end(), 0.0f);
+    positions.fill (0);
+    std::fill (std::begin (dampingStates), std::end (dampingStates), 0.0f);
+}
+
+bool FdnReverb::isPrime (int n) noexcept
+{
+    if (n < 2)
+        return false;
+
+    for (int divisor = 2; divisor * divisor <= n; ++divisor)
+        if (n % divisor == 0)
+            return false;
+
+    return true;
+}
+
+void FdnReverb::setParameters (Lines lines, float size, float decaySeconds, float dampingHz)
+{
+    decaySeconds = juce::jlimit (minDecaySeconds, maxDecaySeconds, decaySeconds);
+
+    bool lengthsChanged = lines != currentLines || size != currentSize;
+
+    if (lengthsChanged)
+    {
+        currentLines = lines;
+        currentSize = size;
+        numLines = lines == Lines::sixteen ? 16 : 8;
+        updateLengths();
+    }
+
+    if (lengthsChanged || decaySeconds != currentDecay)
+    {
+        currentDecay = decaySeconds;
+        updateGains();
+    }
+
+    if (dampingHz != currentDamping)
+    {
+        currentDamping = dampingHz;
+        auto cutoff = juce::jlimit (20.0, 0.49 * sampleRate, (double) dampingHz);
+        dampingCoefficient = (float) std::exp (-juce::MathConstants<double>::twoPi * cutoff / sampleRate);
+    }
+}
+
+void FdnReverb::updateLengths()
+{
+    // Geometrically spaced lengths, each moved up to the next prime that isn't
+    // taken yet. Distinct primes are mutually prime, so the echo patterns of
+    // the lines never line up.
+    auto scale = 0.25 + 0.75 * (double) juce::jlimit (0.0f, 1.0f, currentSize);
+    auto shortest = shortestLineSeconds * scale * sampleRate;
+    auto longest = longestLineSeconds * scale * sampleRate;
+
+    for (int line = 0; line < numLines; ++line)
+    {
+        auto target = shortest * std::pow (longest / shortest, (double) line / (numLines - 1));
+        int length = juce::jmax (2, (int) target);
+
+        while (! isPrime (length) || std::find (lengths.begin(), lengths.begin() + line, length) != lengths.begin() + line)
+            ++length;
+
+        lengths[(size_t) line] = juce::jmin (length, lineCapacity);
+        positions[(size_t) line] %= lengths[(size_t) line];
+    }
+}
+
+void FdnReverb::updateGains()
+{
+    // -60 dB after decaySeconds, whatever the length of the line
+    for (int line = 0; line < maxLines; ++line)
+    {
+        decayGains[line] = line < numLines
+                         ? (float) std::pow (10.0, -3.0 * lengths[(size_t) line] / (currentDecay * sampleRate))
+                         : 0.0f;
+    }
+}
+
+void FdnReverb::hadamard (float* values) const noexcept
+{
+    for (int half = 1; half < numLines; half *= 2)
+    {
+        for (int start = 0; start < numLines; start += 2 * half)
+        {
+            if (half >= 4)
+            {
+                for (int i = start; i < start + half; i += 4)
+                {
+                    auto a = Float4::load (values + i);
+                    auto b = Float4::load (values + i + half);
+                    (a + b).store (values + i);
+                    (a - b).store (values + i + half);
+                }
+            }
+            else
+            {
+                for (int i = start; i < start + half; ++i)
+                {
+                    auto a = values[i];
+                    auto b = values[i + half];
+                    values[i] = a + b;
+                    values[i + half] = a - b;
+                }
+            }
+        }
+    }
+}
+
+void FdnReverb::process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept
+{
+    if (arena.empty() || numChannels <= 0)
+        return;
+
+    // The unnormalised transform scales by sqrt(N), which this takes back out
+    auto normalisation = Float4::broadcast (1.0f / std::sqrt ((float) numLines));
+    auto damping = Float4::broadcast (dampingCoefficient);
+    auto outputGain = 1.0f / std::sqrt ((float) numLines * 0.5f);
+    auto* lines = arena.data();
+
+    alignas (16) float taps[maxLines];
+    alignas (16) float feedback[maxLines];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int line = 0; line < numLines; ++line)
+            taps[line] = lines[line * lineCapacity + positions[(size_t) line]];
+
+        // Per-line low-pass and decay, four lines at a time
+        for (int line = 0; line < numLines; line += 4)
+        {
+            auto tap = Float4::load (taps + line);
+            auto state = Float4::load (dampingStates + line);
+            state = Float4::multiplyAdd (tap, state - tap, damping);
+            state.store (dampingStates + line);
+            (state * Float4::load (decayGains + line) * normalisation).store (feedback + line);
+        }
+
+        hadamard (feedback);
+
+        // Lines alternate between the channels and flip sign every other pair,
+        // so a mono input still excites a decorrelated field
+        float left = 0.0f, right = 0.0f;
+
+        for (int line = 0; line < numLines; ++line)
+        {
+            auto channel = line % numChannels;
+            auto sign = (line & 2) != 0 ? -1.0f : 1.0f;
+            auto& position = positions[(size_t) line];
+
+            lines[line * lineCapacity + position] = feedback[line] + sign * input[channel][i];
+
+            if (++position >= lengths[(size_t) line])
+                position = 0;
+
+            if ((line & 1) == 0)
+                left += sign * taps[line];
+            else
+                right += sign * taps[line];
+        }
+
+        if (numChannels > 1)
+        {
+            output[0][i] = left * outputGain;
+            output[1][i] = right * outputGain;
+        }
+        else
+        {
+            output[0][i] = (left + right) * 0.5f * outputGain;
+        }
+    }
+}
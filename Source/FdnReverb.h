@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    FdnReverb.h
+    Feedback delay network reverb with a Hadamard feedback matrix.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    A feedback delay network of 8 or 16 delay lines. The line lengths are
+    distinct primes, so no two lines share a common period, and the outputs are
+    mixed by a Hadamard matrix applied as a fast Walsh-Hadamard butterfly
+    (N log N adds instead of an N x N multiply).
+
+    Every line has its own decay gain, set from its length so all of them reach
+    -60 dB after the same time, followed by a one-pole low-pass that makes the
+    highs die away faster. All lines share one contiguous arena, which is
+    allocated in prepare() for the largest size, so changing the size or line
+    count never allocates.
+*/
+class FdnReverb
+{
+public:
+    static constexpr int maxLines = 16;
+
+    enum class Lines
+    {
+        eight = 0,
+        sixteen
+    };
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Size runs from 0 to 1 and scales the line lengths. Only recomputes what
+        actually changed since the last call.
+    */
+    void setParameters (Lines lines, float size, float decaySeconds, float dampingHz);
+
+    /** Feeds the input channels into the network and writes the stereo wet
+        signal to output. With a single output channel the two sides are summed.
+    */
+    void process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+    static constexpr float minDecaySeconds = 0.1f;
+    static constexpr float maxDecaySeconds = 20.0f;
+
+private:
+    void updateLengths();
+    void updateGains();
+    static bool isPrime (int n) noexcept;
+
+    /** In-place, unnormalised Walsh-Hadamard transform of numLines values. */
+    void hadamard (float* values) const noexcept;
+
+    static constexpr float shortestLineSeconds = 0.011f;
+    static constexpr float longestLineSeconds = 0.097f;
+
+    std::vector<float> arena;
+    int lineCapacity = 0;
+    int numLines = 8;
+    std::array<int, maxLines> lengths {};
+    std::array<int, maxLines> positions {};
+
+    alignas (16) float decayGains[maxLines] {};
+    alignas (16) float dampingStates[maxLines] {};
+    float dampingCoefficient = 0.0f;
+
+    double sampleRate = 44100.0;
+    Lines currentLines = Lines::eight;
+    float currentSize = -1.0f, currentDecay = -1.0f, currentDamping = -1.0f;
+};
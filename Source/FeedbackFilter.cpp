@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    FeedbackFilter.cpp
+    Low-cut and high-cut filtering for the repeats, processed across channels.
+
+  ==============================================================================
+*/
+
+#include "FeedbackFilter.h"
+
+//==============================================================================
+void FeedbackFilter::Stage::setCoefficients (double newB0, double newB1, double newB2, double a0, double newA1, double newA2)
+{
+    b0 = Float4::broadcast ((float) (newB0 / a0));
+    b1 = Float4::broadcast ((float) (newB1 / a0));
+    b2 = Float4::broadcast ((float) (newB2 / a0));
+    a1 = Float4::broadcast ((float) (newA1 / a0));
+    a2 = Float4::broadcast ((float) (newA2 / a0));
+}
+
+//==============================================================================
+void FeedbackFilter::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    currentLowCut = currentHighCut = -1.0f;
+    reset();
+}
+
+void FeedbackFilter::reset()
+{
+    for (auto* stage : { &lowCut, &highCut })
+        stage->s1 = stage->s2 = Float4::broadcast (0.0f);
+}
+
+void FeedbackFilter::setParameters (float lowCutHz, float highCutHz, Slope slope)
+{
+    if (lowCutHz == currentLowCut && highCutHz == currentHighCut && slope == currentSlope)
+        return;
+
+    currentLowCut = lowCutHz;
+    currentHighCut = highCutHz;
+    currentSlope = slope;
+
+    updateCoefficients();
+}
+
+void FeedbackFilter::updateCoefficients()
+{
+    // Keep both cutoffs safely below Nyquist at low host rates
+    auto nyquistLimit = 0.49 * sampleRate;
+    auto low = juce::jmin ((double) currentLowCut, nyquistLimit);
+    auto high = juce::jmin ((double) currentHighCut, nyquistLimit);
+
+    if (currentSlope == Slope::onePole)
+    {
+        // Bilinear-transformed first order sections
+        auto k = std::tan (juce::MathConstants<double>::pi * low / sampleRate);
+        lowCut.setCoefficients (1.0, -1.0, 0.0, 1.0 + k, k - 1.0, 0.0);
+
+        k = std::tan (juce::MathConstants<double>::pi * high / sampleRate);
+        highCut.setCoefficients (k, k, 0.0, 1.0 + k, k - 1.0, 0.0);
+        return;
+    }
+
+    // Butterworth biquads, from the RBJ cookbook
+    auto alphaFor = [this] (double frequency, double& cosine)
+    {
+        auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        cosine = std::cos (omega);
+        return std::sin (omega) / juce::MathConstants<double>::sqrt2; // Q = 1 / sqrt (2)
+    };
+
+    double cosine;
+    auto alpha = alphaFor (low, cosine);
+    lowCut.setCoefficients ((1.0 + cosine) * 0.5, -(1.0 + cosine), (1.0 + cosine) * 0.5, 1.0 + alpha, -2.0 * cosine, 1.0 - alpha);
+
+    alpha = alphaFor (high, cosine);
+    highCut.setCoefficients ((1.0 - cosine) * 0.5, 1.0 - cosine, (1.0 - cosine) * 0.5, 1.0 + alpha, -2.0 * cosine, 1.0 - alpha);
+}
+
+void FeedbackFilter::processFrame (float* frame) noexcept
+{
+    highCut.process (lowCut.process (Float4::load (frame))).store (frame);
+}
+
+void FeedbackFilter::processChannels (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels);
+    float frame[maxChannels] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = channels[channel][i];
+
+        processFrame (frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel][i] = frame[channel];
+    }
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    FeedbackFilter.h
+    Low-cut and high-cut filtering for the repeats, processed across channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    A high-pass followed by a low-pass, both in transposed direct form II. Each
+    SIMD lane carries one channel, so up to four channels are filtered with the
+    same instructions. The 6 dB/oct slope uses one-pole sections and the
+    12 dB/oct slope uses biquads.
+*/
+class FeedbackFilter
+{
+public:
+    static constexpr int maxChannels = 4;
+
+    enum class Slope
+    {
+        onePole = 0,
+        biquad
+    };
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Updates the cutoffs. The coefficients are only recomputed if something
+        actually changed since the last call.
+    */
+    void setParameters (float lowCutHz, float highCutHz, Slope slope);
+
+    /** Filters one frame in place. The frame must hold maxChannels floats. */
+    void processFrame (float* frame) noexcept;
+
+    /** Filters a block of separate channel buffers in place. */
+    void processChannels (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** The ends of the cutoff ranges. With both cutoffs there, the filter can be
+        left out of the loop.
+    */
+    static constexpr float minLowCut = 20.0f;
+    static constexpr float maxHighCut = 20000.0f;
+
+private:
+    struct Stage
+    {
+        void setCoefficients (double b0, double b1, double b2, double a0, double a1, double a2);
+
+        Float4 process (Float4 input) noexcept
+        {
+            auto output = Float4::multiplyAdd (s1, b0, input);
+            s1 = Float4::multiplyAdd (s2, b1, input) - a1 * output;
+            s2 = b2 * input - a2 * output;
+            return output;
+        }
+
+        Float4 b0, b1, b2, a1, a2;
+        Float4 s1 = Float4::broadcast (0.0f), s2 = Float4::broadcast (0.0f);
+    };
+
+    void updateCoefficients();
+
+    Stage lowCut, highCut;
+    double sampleRate = 44100.0;
+    float currentLowCut = -1.0f, currentHighCut = -1.0f;
+    Slope currentSlope = Slope::biquad;
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    FeedbackMatrix.cpp
+    Channel routing for the repeats: ping-pong, cross-feed and stereo rotations.
+
+  ==============================================================================
+*/
+
+#include "FeedbackMatrix.h"
+
+//==============================================================================
+FeedbackMatrix::FeedbackMatrix()
+{
+    setRouting (Routing::normal, 0.0f);
+}
+
+void FeedbackMatrix::setRouting (Routing newRouting, float newAmount)
+{
+    if (newRouting == routing && newAmount == amount)
+        return;
+
+    routing = newRouting;
+    amount = newAmount;
+
+    for (int row = 0; row < maxChannels; ++row)
+        for (int column = 0; column < maxChannels; ++column)
+            coefficients[row][column] = row == column ? 1.0f : 0.0f;
+
+    // The routings act on the first two channels; any others feed back to themselves
+    auto setStereo = [this] (float leftToLeft, float rightToLeft, float leftToRight, float rightToRight)
+    {
+        coefficients[0][0] = leftToLeft;
+        coefficients[0][1] = rightToLeft;
+        coefficients[1][0] = leftToRight;
+        coefficients[1][1] = rightToRight;
+    };
+
+    switch (routing)
+    {
+        case Routing::pingPong:
+            setStereo (0.0f, 1.0f, 1.0f, 0.0f);
+            break;
+
+        case Routing::crossFeed:
+            setStereo (1.0f - amount, amount, amount, 1.0f - amount);
+            break;
+
+        case Routing::rotate:
+        {
+            // Turns the stereo image by up to 90 degrees on every repeat. In M/S
+            // terms this is the same rotation, just in the opposite direction.
+            auto angle = amount * juce::MathConstants<float>::halfPi;
+            setStereo (std::cos (angle), -std::sin (angle), std::sin (angle), std::cos (angle));
+            break;
+        }
+
+        case Routing::midSide:
+        {
+            // Keeps the mid and scales the side, narrowing each repeat towards mono
+            auto side = amount;
+            setStereo (0.5f * (1.0f + side), 0.5f * (1.0f - side), 0.5f * (1.0f - side), 0.5f * (1.0f + side));
+            break;
+        }
+
+        case Routing::normal:
+        default:
+            break;
+    }
+
+    identity = true;
+
+    for (int column = 0; column < maxChannels; ++column)
+    {
+        float values[maxChannels];
+
+        for (int row = 0; row < maxChannels; ++row)
+        {
+            values[row] = coefficients[row][column];
+            identity = identity && values[row] == (row == column ? 1.0f : 0.0f);
+        }
+
+        columns[column] = Float4::load (values);
+    }
+}
+
+void FeedbackMatrix::processChannels (const float* const* source, float* const* destination, int numChannels, int numSamples) const noexcept
+{
+    jassert (numChannels <= maxChannels);
+
+    for (int row = 0; row < numChannels; ++row)
+    {
+        juce::FloatVectorOperations::copyWithMultiply (destination[row], source[0], coefficients[row][0], numSamples);
+
+        for (int column = 1; column < numChannels; ++column)
+            juce::FloatVectorOperations::addWithMultiply (destination[row], source[column], coefficients[row][column], numSamples);
+    }
+}
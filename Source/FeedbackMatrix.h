@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    FeedbackMatrix.h
+    Channel routing for the repeats: ping-pong, cross-feed and stereo rotations.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    An N x N matrix (N <= 4) that mixes the delayed channels before they are
+    fed back. A frame is mixed as a sum of matrix columns scaled by each input
+    channel, so every output channel comes out of the same SIMD operations.
+
+    Every routing keeps the matrix norm at or below 1, so it can't make the
+    loop unstable by itself.
+*/
+class FeedbackMatrix
+{
+public:
+    static constexpr int maxChannels = 4;
+
+    enum class Routing
+    {
+        normal = 0,
+        pingPong,
+        crossFeed,
+        rotate,
+        midSide
+    };
+
+    FeedbackMatrix();
+
+    /** Rebuilds the matrix if the routing or its amount (0 to 1) changed. */
+    void setRouting (Routing newRouting, float newAmount);
+
+    bool isIdentity() const noexcept                    { return identity; }
+
+    /** Ping-pong feeds a mono sum of the input into the first channel only. */
+    bool routesInputToFirstChannel() const noexcept     { return routing == Routing::pingPong; }
+
+    /** destination = matrix * source, for one frame of maxChannels floats. */
+    void processFrame (const float* source, float* destination) const noexcept
+    {
+        auto sum = columns[0] * Float4::broadcast (source[0]);
+
+        for (int column = 1; column < maxChannels; ++column)
+            sum = Float4::multiplyAdd (sum, columns[column], Float4::broadcast (source[column]));
+
+        sum.store (destination);
+    }
+
+    /** destination = matrix * source for whole blocks of separate channel buffers. */
+    void processChannels (const float* const* source, float* const* destination, int numChannels, int numSamples) const noexcept;
+
+private:
+    float coefficients[maxChannels][maxChannels];
+    Float4 columns[maxChannels];
+    Routing routing = Routing::normal;
+    float amount = -1.0f;
+    bool identity = true;
+};
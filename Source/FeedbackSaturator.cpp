@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    FeedbackSaturator.cpp
+    Oversampled soft clipping for the repeats.
+
+  ==============================================================================
+*/
+
+#include "FeedbackSaturator.h"
+
+//==============================================================================
+void FeedbackSaturator::reset()
+{
+    for (auto* upsampler : { &firstUp, &secondUp })
+        upsampler->reset();
+
+    for (auto* downsampler : { &firstDown, &secondDown })
+        downsampler->reset();
+}
+
+void FeedbackSaturator::setOversampling (Oversampling newOversampling) noexcept
+{
+    if (newOversampling != oversampling)
+    {
+        oversampling = newOversampling;
+        firstDown.delayByOneSample = oversampling == Oversampling::fourTimes;
+        reset();
+    }
+}
+
+void FeedbackSaturator::setDrive (float newDrive) noexcept
+{
+    drive = juce::jmax (1.0f, newDrive);
+}
+
+int FeedbackSaturator::getLatencyInSamples() const noexcept
+{
+    // An up/down pair delays by 2 * (2 * halfTaps - 1) samples at its oversampled
+    // rate. At 4x the inner pair comes to a fractional number of host samples, so
+    // the outer one adds half a host sample to round it off.
+    constexpr int pairLatency = 2 * halfTaps - 1;
+
+    switch (oversampling)
+    {
+        case Oversampling::twoTimes:    return pairLatency;
+        case Oversampling::fourTimes:   return pairLatency + (2 * pairLatency + 2) / 4;
+        case Oversampling::off:
+        default:                        return 0;
+    }
+}
+
+Float4 FeedbackSaturator::fastTanh (Float4 x) noexcept
+{
+    auto limit = Float4::broadcast (3.0f);
+    x = Float4::max (Float4::min (x, limit), Float4::broadcast (-3.0f));
+
+    auto x2 = x * x;
+    auto twentySeven = Float4::broadcast (27.0f);
+    return x * (twentySeven + x2) / Float4::multiplyAdd (twentySeven, Float4::broadcast (9.0f), x2);
+}
+
+Float4 FeedbackSaturator::saturate (Float4 x) const noexcept
+{
+    // Scaled back down by the drive so quiet repeats pass at unity gain
+    return fastTanh (x * Float4::broadcast (drive)) * Float4::broadcast (1.0f / drive);
+}
+
+void FeedbackSaturator::processFrame (float* frame) noexcept
+{
+    Float4 a, b;
+    firstUp.process (Float4::load (frame), a, b);
+
+    if (oversampling == Oversampling::fourTimes)
+    {
+        Float4 a1, a2, b1, b2;
+        secondUp.process (a, a1, a2);
+        secondUp.process (b, b1, b2);
+
+        a = secondDown.process (saturate (a1), saturate (a2));
+        b = secondDown.process (saturate (b1), saturate (b2));
+    }
+    else
+    {
+        a = saturate (a);
+        b = saturate (b);
+    }
+
+    firstDown.process (a, b).store (frame);
+}
+
+void FeedbackSaturator::processChannels (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert (numChannels <= maxChannels);
+    float frame[maxChannels] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = channels[channel][i];
+
+        processFrame (frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel][i] = frame[channel];
+    }
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    FeedbackSaturator.h
+    Oversampled soft clipping for the repeats.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfbandFilter.h"
+
+//==============================================================================
+/**
+    A tanh-style soft clipper that runs at 2x or 4x the host rate, so the
+    harmonics it adds don't fold back into the audible band.
+
+    Rate changes use the polyphase half-band filters in HalfbandFilter.h. Like
+    FeedbackFilter, every SIMD lane carries one channel.
+*/
+class FeedbackSaturator
+{
+public:
+    static constexpr int maxChannels = 4;
+
+    enum class Oversampling
+    {
+        off = 0,
+        twoTimes,
+        fourTimes
+    };
+
+    void reset();
+
+    void setOversampling (Oversampling newOversampling) noexcept;
+    void setDrive (float newDrive) noexcept;
+
+    bool isEnabled() const noexcept      { return oversampling != Oversampling::off; }
+
+    /** The delay added by the rate-change filters, in host-rate samples. */
+    int getLatencyInSamples() const noexcept;
+
+    /** Saturates one frame in place. The frame must hold maxChannels floats. */
+    void processFrame (float* frame) noexcept;
+
+    /** Saturates a block of separate channel buffers in place. */
+    void processChannels (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Rational approximation of tanh, exact at 0 and clamped to +/-1 from |x| = 3. */
+    static Float4 fastTanh (Float4 x) noexcept;
+
+    /** Half the number of non-zero side taps in each half-band filter. */
+    static constexpr int halfTaps = Halfband::halfTaps;
+
+private:
+    //==============================================================================
+    Float4 saturate (Float4 x) const noexcept;
+
+    Halfband::Upsampler firstUp, secondUp;
+    Halfband::Downsampler firstDown, secondDown;
+    Oversampling oversampling = Oversampling::off;
+    float drive = 1.0f;
+};
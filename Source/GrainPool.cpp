@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    GrainPool.cpp
+    A fixed set of grains reading from the delay line, stored as arrays.
+
+  ==============================================================================
+*/
+
+#include "GrainPool.h"
+
+//==============================================================================
+namespace
+{
+    // Anything at or past 1 is silent, which also covers the unused lanes of
+    // the last batch
+    constexpr float finishedPhase = 2.0f;
+}
+
+void GrainPool::prepare()
+{
+    for (auto* array : { &readPositions, &speeds, &phases, &phaseIncrements, &leftGains, &rightGains })
+        array->assign ((size_t) capacity, 0.0f);
+
+    reset();
+}
+
+void GrainPool::reset()
+{
+    std::fill (readPositions.begin(), readPositions.end(), 0.0f);
+    std::fill (speeds.begin(), speeds.end(), 0.0f);
+    std::fill (phases.begin(), phases.end(), finishedPhase);
+    std::fill (phaseIncrements.begin(), phaseIncrements.end(), 0.0f);
+    numActive = 0;
+}
+
+bool GrainPool::spawn (float readPosition, float speed, float lengthInSamples, float startPhase, float pan) noexcept
+{
+    if (numActive >= (int) phases.size())
+        return false;
+
+    // Equal-power pan, pan running from -1 to 1
+    auto angle = (juce::jlimit (-1.0f, 1.0f, pan) + 1.0f) * juce::MathConstants<float>::pi * 0.25f;
+    auto slot = (size_t) numActive++;
+
+    readPositions[slot] = readPosition;
+    speeds[slot] = speed;
+    phases[slot] = startPhase;
+    phaseIncrements[slot] = 1.0f / juce::jmax (1.0f, lengthInSamples);
+    leftGains[slot] = std::cos (angle);
+    rightGains[slot] = std::sin (angle);
+    return true;
+}
+
+void GrainPool::retire (int index) noexcept
+{
+    auto last = (size_t) --numActive;
+    auto slot = (size_t) index;
+
+    readPositions[slot] = readPositions[last];
+    speeds[slot] = speeds[last];
+    phases[slot] = phases[last];
+    phaseIncrements[slot] = phaseIncrements[last];
+    leftGains[slot] = leftGains[last];
+    rightGains[slot] = rightGains[last];
+
+    // The slot stays in the last batch, so it must stay silent and in range
+    readPositions[last] = 0.0f;
+    speeds[last] = 0.0f;
+    phases[last] = finishedPhase;
+    phaseIncrements[last] = 0.0f;
+}
+
+void GrainPool::process (const float* ringLeft, const float* ringRight, int ringSize,
+                         float* left, float* right, int numSamples) noexcept
+{
+    auto zero = Float4::broadcast (0.0f);
+    auto one = Float4::broadcast (1.0f);
+    auto four = Float4::broadcast (4.0f);
+
+    for (int batch = 0; batch < numActive; batch += 4)
+    {
+        alignas (16) float positions[4];
+        alignas (16) float samples[4];
+        auto position = Float4::load (readPositions.data() + batch);
+        auto speed = Float4::load (speeds.data() + batch);
+        auto phase = Float4::load (phases.data() + batch);
+        auto phaseIncrement = Float4::load (phaseIncrements.data() + batch);
+        auto leftGain = Float4::load (leftGains.data() + batch);
+        auto rightGain = Float4::load (rightGains.data() + batch);
+
+        if (right == nullptr)
+            leftGain = (leftGain + rightGain) * Float4::broadcast (juce::MathConstants<float>::sqrt2 * 0.5f);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            position.store (positions);
+
+            // The reads are the only part that can't be done across lanes
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                auto index = (int) std::floor (positions[lane]);
+                auto fraction = positions[lane] - (float) index;
+
+                if (index < 0)
+                    index += ringSize;
+                else if (index >= ringSize)
+                    index -= ringSize;
+
+                auto a = ringLeft[index] + ringRight[index];
+                auto b = ringLeft[index + 1] + ringRight[index + 1];
+                samples[lane] = 0.5f * (a + fraction * (b - a));
+            }
+
+            // Parabolic window, clamped to zero outside the grain
+            auto window = Float4::max (zero, four * phase * (one - phase));
+            auto grain = Float4::load (samples) * window;
+
+            left[i] += (grain * leftGain).sum();
+
+            if (right != nullptr)
+                right[i] += (grain * rightGain).sum();
+
+            position = position + speed;
+            phase = phase + phaseIncrement;
+        }
+
+        position.store (readPositions.data() + batch);
+        phase.store (phases.data() + batch);
+    }
+
+    // Keep the positions inside the ring and drop the grains that finished
+    for (int grain = numActive; --grain >= 0;)
+    {
+        auto& position = readPositions[(size_t) grain];
+        position = std::fmod (position, (float) ringSize);
+
+        if (position < 0.0f)
+            position += (float) ringSize;
+
+        if (phases[(size_t) grain] >= 1.0f)
+            retire (grain);
+    }
+}
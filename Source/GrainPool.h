@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    GrainPool.h
+    A fixed set of grains reading from the delay line, stored as arrays.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    Holds up to `capacity` grains as separate arrays of read position, speed,
+    window phase and pan, with the active grains packed at the front. Blocks
+    are rendered four grains at a time, one grain per SIMD lane.
+
+    All storage is allocated in prepare(). Spawning takes the next free slot and
+    retiring a grain moves the last active one into its place, so the audio
+    thread never allocates or locks.
+*/
+class GrainPool
+{
+public:
+    static constexpr int capacity = 128;
+
+    void prepare();
+    void reset();
+
+    /** Starts a grain, or returns false if the pool is full.
+
+        readPosition is where the grain would be at the first sample of the next
+        block, and startPhase is negative for a grain that starts later in that
+        block: it stays silent until its phase reaches zero.
+    */
+    bool spawn (float readPosition, float speed, float lengthInSamples, float startPhase, float pan) noexcept;
+
+    int getNumActive() const noexcept       { return numActive; }
+
+    /** Adds the grains to left and right (or just left, if right is null), reading the mono sum of the two ring
+        channels. ringSize is the ring length; the ring must be followed by at
+        least one guard sample that mirrors its start.
+    */
+    void process (const float* ringLeft, const float* ringRight, int ringSize,
+                  float* left, float* right, int numSamples) noexcept;
+
+private:
+    void retire (int index) noexcept;
+
+    std::vector<float> readPositions, speeds, phases, phaseIncrements, leftGains, rightGains;
+    int numActive = 0;
+};
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    HalfbandFilter.cpp
+    Polyphase half-band filters for 2x rate changes, four channels at a time.
+
+  ==============================================================================
+*/
+
+#include "HalfbandFilter.h"
+
+namespace
+{
+    constexpr int numSideTaps = 2 * Halfband::halfTaps;
+
+    // The non-zero side taps of a 4 * halfTaps - 1 long Blackman-windowed
+    // half-band low-pass. The centre tap is 0.5 and every other tap is zero.
+    struct HalfbandCoefficients
+    {
+        HalfbandCoefficients()
+        {
+            auto centre = numSideTaps - 1;
+            auto length = 2 * numSideTaps - 1;
+            double total = 0.0;
+
+            for (int i = 0; i < numSideTaps; ++i)
+            {
+                auto offset = 2 * i - centre;
+                auto x = juce::MathConstants<double>::pi * offset / 2.0;
+                auto window = 0.42 - 0.5 * std::cos (juce::MathConstants<double>::twoPi * (2 * i + 1) / (length + 1))
+                                   + 0.08 * std::cos (2.0 * juce::MathConstants<double>::twoPi * (2 * i + 1) / (length + 1));
+                auto value = 0.5 * std::sin (x) / x * window;
+
+                taps[i] = Float4::broadcast ((float) value);
+                values[i] = value;
+                total += value;
+            }
+
+            // The side taps have to add up to 0.5 for unity gain at DC
+            for (int i = 0; i < numSideTaps; ++i)
+            {
+                taps[i] = Float4::broadcast ((float) (values[i] * 0.5 / total));
+                doubledTaps[i] = Float4::broadcast ((float) (values[i] / total));
+            }
+        }
+
+        double values[numSideTaps];
+        Float4 taps[numSideTaps], doubledTaps[numSideTaps];
+    };
+
+    const HalfbandCoefficients& getHalfband()
+    {
+        static const HalfbandCoefficients coefficients;
+        return coefficients;
+    }
+}
+
+//==============================================================================
+void Halfband::Upsampler::process (Float4 input, Float4& first, Float4& second) noexcept
+{
+    const auto& halfband = getHalfband();
+    history.push (input);
+
+    // Even outputs come from the side taps (doubled to make up for the inserted
+    // zeros), odd outputs are just the input delayed to the centre tap
+    auto sum = Float4::broadcast (0.0f);
+
+    for (int i = 0; i < numSideTaps; ++i)
+        sum = Float4::multiplyAdd (sum, halfband.doubledTaps[i], history[i]);
+
+    first = sum;
+    second = history[halfTaps - 1];
+}
+
+Float4 Halfband::Downsampler::process (Float4 first, Float4 second) noexcept
+{
+    const auto& halfband = getHalfband();
+    Float4 sum;
+
+    evenHistory.push (first);
+
+    if (delayByOneSample)
+    {
+        // Filters the input delayed by one sample at the higher rate, so the
+        // odd samples take the side taps and the even ones the centre tap
+        sum = evenHistory[halfTaps] * Float4::broadcast (0.5f);
+
+        for (int i = 0; i < numSideTaps; ++i)
+            sum = Float4::multiplyAdd (sum, halfband.taps[i], oddHistory[i]);
+    }
+    else
+    {
+        sum = oddHistory[halfTaps - 1] * Float4::broadcast (0.5f);
+
+        for (int i = 0; i < numSideTaps; ++i)
+            sum = Float4::multiplyAdd (sum, halfband.taps[i], evenHistory[i]);
+    }
+
+    oddHistory.push (second);
+    return sum;
+}
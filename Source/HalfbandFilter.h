@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    HalfbandFilter.h
+    Polyphase half-band filters for 2x rate changes, four channels at a time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    2x up- and downsampling through a Blackman-windowed half-band low-pass.
+    Each stage only evaluates the non-zero taps of its branch, and the
+    centre-tap branch is a pure delay. Every SIMD lane carries one channel.
+
+    An up/down pair delays by 2 * (2 * halfTaps - 1) samples at the higher
+    of the two rates.
+*/
+namespace Halfband
+{
+    /** Half the number of non-zero side taps in each filter. */
+    constexpr int halfTaps = 6;
+
+    /** A short history of frames, newest first, readable as one contiguous run. */
+    struct History
+    {
+        static constexpr int length = 2 * halfTaps;
+
+        void push (Float4 frame) noexcept
+        {
+            position = (position + length - 1) % length;
+            frames[position] = frames[position + length] = frame;
+        }
+
+        const Float4& operator[] (int age) const noexcept   { return frames[position + age]; }
+
+        Float4 frames[2 * length] {};
+        int position = 0;
+    };
+
+    /** Turns one frame into two at twice the rate. */
+    struct Upsampler
+    {
+        void process (Float4 input, Float4& first, Float4& second) noexcept;
+        void reset() noexcept       { history = {}; }
+
+        History history;
+    };
+
+    /** Turns two frames into one at half the rate. */
+    struct Downsampler
+    {
+        Float4 process (Float4 first, Float4 second) noexcept;
+        void reset() noexcept       { evenHistory = oddHistory = {}; }
+
+        History evenHistory, oddHistory;
+        bool delayByOneSample = false;
+    };
+}
@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    ModulationLFO.cpp
+    Block-rate LFO for modulating the delay read position.
+
+  ==============================================================================
+*/
+
+#include "ModulationLFO.h"
+#include "SIMDVector.h"
+
+namespace
+{
+    // One sine cycle plus a guard point so index + 1 never needs wrapping
+    const float* getSineTable()
+    {
+        static const auto table = []
+        {
+            std::array<float, ModulationLFO::tableSize + 1> values;
+
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = (float) std::sin (juce::MathConstants<double>::twoPi * (double) i / ModulationLFO::tableSize);
+
+            return values;
+        }();
+
+        return table.data();
+    }
+
+    // Phases for the next four samples, wrapped into [0, 1)
+    void getPhases (float start, float increment, float* phases) noexcept
+    {
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            auto p = start + increment * (float) lane;
+            phases[lane] = p - std::floor (p);
+        }
+    }
+}
+
+//==============================================================================
+void ModulationLFO::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void ModulationLFO::reset()
+{
+    phase = 0.0f;
+    randomStart = random.nextFloat() * 2.0f - 1.0f;
+    randomEnd = random.nextFloat() * 2.0f - 1.0f;
+}
+
+void ModulationLFO::setFrequency (float newFrequencyHz) noexcept
+{
+    increment = (float) (newFrequencyHz / sampleRate);
+}
+
+void ModulationLFO::process (float* destination, int numSamples) noexcept
+{
+    switch (shape)
+    {
+        case Shape::sine:           processSine (destination, numSamples); break;
+        case Shape::triangle:       processTriangle (destination, numSamples); break;
+        case Shape::randomSmooth:   processRandom (destination, numSamples); break;
+        default:                    break;
+    }
+}
+
+void ModulationLFO::processSine (float* destination, int numSamples) noexcept
+{
+    const auto* table = getSineTable();
+    float phases[4], lower[4], upper[4], fractions[4];
+
+    for (int i = 0; i < numSamples; i += 4)
+    {
+        getPhases (phase + phaseOffset + increment * (float) i, increment, phases);
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            auto position = phases[lane] * (float) tableSize;
+            auto index = juce::jmin (tableSize - 1, (int) position);
+            fractions[lane] = position - (float) index;
+            lower[lane] = table[index];
+            upper[lane] = table[index + 1];
+        }
+
+        auto low = Float4::load (lower);
+        auto result = Float4::multiplyAdd (low, Float4::load (upper) - low, Float4::load (fractions));
+
+        float values[4];
+        result.store (values);
+        std::copy (values, values + juce::jmin (4, numSamples - i), destination + i);
+    }
+
+    phase += increment * (float) numSamples;
+    phase -= std::floor (phase);
+}
+
+void ModulationLFO::processTriangle (float* destination, int numSamples) noexcept
+{
+    float phases[4], values[4];
+    auto half = Float4::broadcast (0.5f);
+    auto zero = Float4::broadcast (0.0f);
+
+    for (int i = 0; i < numSamples; i += 4)
+    {
+        getPhases (phase + phaseOffset + increment * (float) i, increment, phases);
+
+        // 4 * |phase - 0.5| - 1
+        auto centred = Float4::load (phases) - half;
+        auto magnitude = Float4::max (centred, zero - centred);
+        (magnitude * Float4::broadcast (4.0f) - Float4::broadcast (1.0f)).store (values);
+
+        std::copy (values, values + juce::jmin (4, numSamples - i), destination + i);
+    }
+
+    phase += increment * (float) numSamples;
+    phase -= std::floor (phase);
+}
+
+void ModulationLFO::processRandom (float* destination, int numSamples) noexcept
+{
+    // Only needs a new random number once per cycle, so this stays scalar. Each
+    // instance draws its own targets, so the phase offset isn't needed here.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto smooth = phase * phase * (3.0f - 2.0f * phase);
+        destination[i] = randomStart + (randomEnd - randomStart) * smooth;
+
+        phase += increment;
+
+        if (phase >= 1.0f)
+        {
+            phase -= 1.0f;
+            randomStart = randomEnd;
+            randomEnd = random.nextFloat() * 2.0f - 1.0f;
+        }
+    }
+}
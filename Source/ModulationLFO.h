@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    ModulationLFO.h
+    Block-rate LFO for modulating the delay read position.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Fills whole blocks with a bipolar LFO in [-1, 1]. The sine comes from a
+    shared wavetable with linear interpolation and the triangle is computed
+    directly, both four samples at a time. The smooth random shape glides
+    between new random targets once per cycle.
+*/
+class ModulationLFO
+{
+public:
+    enum class Shape
+    {
+        sine = 0,
+        triangle,
+        randomSmooth
+    };
+
+    void prepare (double sampleRate);
+    void reset();
+
+    void setShape (Shape newShape) noexcept        { shape = newShape; }
+    void setFrequency (float newFrequencyHz) noexcept;
+
+    /** Offsets this LFO's phase by a fraction of a cycle, e.g. for a second channel. */
+    void setPhaseOffset (float cycles) noexcept    { phaseOffset = cycles; }
+
+    void process (float* destination, int numSamples) noexcept;
+
+    static constexpr int tableSize = 2048;
+
+private:
+    void processSine (float* destination, int numSamples) noexcept;
+    void processTriangle (float* destination, int numSamples) noexcept;
+    void processRandom (float* destination, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+    float phase = 0.0f, phaseOffset = 0.0f, increment = 0.0f;
+    Shape shape = Shape::sine;
+
+    float randomStart = 0.0f, randomEnd = 0.0f;
+    juce::Random random;
+};
@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+    MultiTapDelay.cpp
+    A static pattern of taps, evaluated tap by tap or by partitioned convolution.
+
+  ==============================================================================
+*/
+
+#include "MultiTapDelay.h"
+
+//==============================================================================
+MultiTapDelay::Costs MultiTapDelay::measureCosts()
+{
+    constexpr int repeats = 64;
+    std::vector<float> a ((size_t) (4 * fftSize), 0.001f), b ((size_t) (4 * fftSize), 0.002f);
+    std::vector<float> fftInput ((size_t) (2 * fftSize), 0.0f), fftBlock ((size_t) (2 * fftSize), 0.0f);
+    juce::dsp::FFT measureFft { juce::roundToInt (std::log2 (fftSize)) };
+    Costs measured;
+
+    for (int i = 0; i < fftSize; ++i)
+        fftInput[(size_t) i] = (float) ((i * 7) % 13) / 13.0f - 0.5f;
+
+    // One untimed pass warms the caches, then the quickest of a few runs is
+    // kept: a stall from the scheduler can only make a run slower, so the
+    // quickest is the one closest to what the code really costs
+    auto secondsFor = [] (auto&& function)
+    {
+        constexpr int runs = 5;
+        function();
+        auto best = std::numeric_limits<double>::max();
+
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            function();
+            best = juce::jmin (best, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+        }
+
+        return best;
+    };
+
+    measured.tap = secondsFor ([&]
+    {
+        for (int i = 0; i < repeats; ++i)
+            juce::FloatVectorOperations::addWithMultiply (a.data(), b.data() + (i & 7), 0.5f, fftSize);
+    }) / (repeats * fftSize);
+
+    // Each transform starts from the same input. Transforming one buffer over
+    // and over would grow it by about fftSize a pass, into infs and NaNs.
+    measured.fft = secondsFor ([&]
+    {
+        for (int i = 0; i < repeats; ++i)
+        {
+            std::copy (fftInput.begin(), fftInput.end(), fftBlock.begin());
+            measureFft.performRealOnlyForwardTransform (fftBlock.data(), true);
+        }
+    }) / repeats;
+
+    measured.partition = secondsFor ([&]
+    {
+        for (int i = 0; i < repeats; ++i)
+        {
+            for (int bin = 0; bin < numBins; bin += 4)
+            {
+                auto re = Float4::load (a.data() + bin), im = Float4::load (a.data() + numBins + bin);
+                auto kernelRe = Float4::load (b.data() + bin), kernelIm = Float4::load (b.data() + numBins + bin);
+                (re * kernelRe - im * kernelIm).store (a.data() + fftSize + bin);
+                (re * kernelIm + im * kernelRe).store (a.data() + fftSize + numBins + bin);
+            }
+        }
+    }) / repeats;
+
+    return measured;
+}
+
+void MultiTapDelay::prepare (double sampleRate, int maxDelayInSamples, int maximumBlockSize)
+{
+    juce::ignoreUnused (sampleRate);
+
+    // Nothing here depends on the rate, so unless the sizes moved, the
+    // history and the current pattern can stay
+    if (maxDelayInSamples == maxDelay && maxDelayInSamples + maximumBlockSize + 1 == historySize && ! history.empty())
+        return;
+
+    // Only measured once, by whichever instance gets here first
+    static const Costs measuredCosts = measureCosts();
+    costs = measuredCosts;
+
+    maxDelay = maxDelayInSamples;
+    historySize = maxDelayInSamples + maximumBlockSize + 1;
+    history.assign ((size_t) (historySize * maxChannels), 0.0f);
+
+    maxPartitions = maxDelayInSamples / partitionSize + 1;
+    kernelReal.assign ((size_t) (maxPartitions * numBins), 0.0f);
+    kernelImag.assign ((size_t) (maxPartitions * numBins), 0.0f);
+    inputReal.assign ((size_t) (maxChannels * maxPartitions * numBins), 0.0f);
+    inputImag.assign ((size_t) (maxChannels * maxPartitions * numBins), 0.0f);
+    usedPartitions.clear();
+    usedPartitions.reserve ((size_t) maxPartitions);
+
+    inputBlocks.assign ((size_t) (maxChannels * fftSize), 0.0f);
+    outputBlocks.assign ((size_t) (maxChannels * partitionSize), 0.0f);
+    fftBuffer.assign ((size_t) (2 * fftSize), 0.0f);
+
+    numTaps = 0;
+    reset();
+}
+
+void MultiTapDelay::reset()
+{
+    std::fill (history.begin(), history.end(), 0.0f);
+    std::fill (inputReal.begin(), inputReal.end(), 0.0f);
+    std::fill (inputImag.begin(), inputImag.end(), 0.0f);
+    std::fill (inputBlocks.begin(), inputBlocks.end(), 0.0f);
+    std::fill (outputBlocks.begin(), outputBlocks.end(), 0.0f);
+    historyPosition = blockPosition = spectrumSlot = blocksFed = 0;
+    convolutionActive = false;
+}
+
+void MultiTapDelay::setPattern (const float* delaysInSamples, const float* gains, int newNumTaps)
+{
+    newNumTaps = juce::jlimit (0, maxTaps, newNumTaps);
+    std::array<Tap, maxTaps> newTaps {};
+
+    for (int i = 0; i < newNumTaps; ++i)
+        newTaps[(size_t) i] = { juce::jlimit (0, maxDelay, juce::roundToInt (delaysInSamples[i])), gains[i] };
+
+    // Short taps first, so each path gets a contiguous range
+    std::sort (newTaps.begin(), newTaps.begin() + newNumTaps, [] (const Tap& x, const Tap& y) { return x.delay < y.delay; });
+
+    bool same = newNumTaps == numTaps;
+
+    for (int i = 0; same && i < newNumTaps; ++i)
+        same = newTaps[(size_t) i].delay == taps[(size_t) i].delay && newTaps[(size_t) i].gain == taps[(size_t) i].gain;
+
+    if (same)
+        return;
+
+    bool wasWanted = convolutionWanted;
+
+    taps = newTaps;
+    numTaps = newNumTaps;
+    numShortTaps = (int) (std::find_if (taps.begin(), taps.begin() + numTaps, [] (const Tap& tap) { return tap.delay >= partitionSize; }) - taps.begin());
+
+    // Which partitions hold a tap, once the FIR is shifted by one partition
+    usedPartitions.clear();
+
+    for (int i = numShortTaps; i < numTaps; ++i)
+    {
+        auto partition = (taps[(size_t) i].delay - partitionSize) / partitionSize;
+
+        if (usedPartitions.empty() || usedPartitions.back() != partition)
+            usedPartitions.push_back (partition);
+    }
+
+    numPartitions = usedPartitions.empty() ? 0 : usedPartitions.back() + 1;
+
+    // Per sample, the taps cost one multiply-add each, and the convolution
+    // costs two FFTs plus one multiply-add per used partition, per block
+    auto timeDomainCost = (numTaps - numShortTaps) * costs.tap;
+    auto convolutionCost = (2.0 * costs.fft + (double) usedPartitions.size() * costs.partition) / partitionSize;
+
+    convolutionWanted = numPartitions > 0 && convolutionCost < timeDomainCost;
+    convolutionActive = false;
+    compiledPartitions = 0;
+
+    // The input spectra don't depend on the pattern, so they only have to be
+    // built up again if they weren't being kept
+    if (! (convolutionWanted && wasWanted))
+        blocksFed = 0;
+}
+
+void MultiTapDelay::compilePartitions (int count) noexcept
+{
+    for (; count > 0 && compiledPartitions < (int) usedPartitions.size(); --count, ++compiledPartitions)
+    {
+        auto partition = usedPartitions[(size_t) compiledPartitions];
+        auto start = partitionSize * (partition + 1);
+        std::fill (fftBuffer.begin(), fftBuffer.end(), 0.0f);
+
+        for (int i = numShortTaps; i < numTaps; ++i)
+            if (taps[(size_t) i].delay >= start && taps[(size_t) i].delay < start + partitionSize)
+                fftBuffer[(size_t) (taps[(size_t) i].delay - start)] += taps[(size_t) i].gain;
+
+        fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+        auto* real = kernelReal.data() + partition * numBins;
+        auto* imag = kernelImag.data() + partition * numBins;
+
+        for (int bin = 0; bin <= partitionSize; ++bin)
+        {
+            real[bin] = fftBuffer[(size_t) (2 * bin)];
+            imag[bin] = fftBuffer[(size_t) (2 * bin + 1)];
+        }
+    }
+}
+
+void MultiTapDelay::addTaps (const Tap* first, const Tap* last, float* const* output, int numChannels,
+                             int startSample, int numSamples, int blockLength) const noexcept
+{
+    // The whole block's input is already in the history, so any delay works
+    for (auto* tap = first; tap != last; ++tap)
+    {
+        auto readPosition = (historyPosition - blockLength + startSample - tap->delay + 2 * historySize) % historySize;
+        auto firstPart = juce::jmin (numSamples, historySize - readPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* channelHistory = history.data() + channel * historySize;
+            auto* destination = output[channel] + startSample;
+            juce::FloatVectorOperations::addWithMultiply (destination, channelHistory + readPosition, tap->gain, firstPart);
+            juce::FloatVectorOperations::addWithMultiply (destination + firstPart, channelHistory, tap->gain, numSamples - firstPart);
+        }
+    }
+}
+
+void MultiTapDelay::convolveBlock (int numChannels) noexcept
+{
+    spectrumSlot = (spectrumSlot + 1) % maxPartitions;
+    ++blocksFed;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* block = inputBlocks.data() + channel * fftSize;
+        auto* channelReal = inputReal.data() + channel * maxPartitions * numBins;
+        auto* channelImag = inputImag.data() + channel * maxPartitions * numBins;
+
+        // Spectrum of the last two partitions of input, into the delay line
+        std::copy (block, block + fftSize, fftBuffer.begin());
+        std::fill (fftBuffer.begin() + fftSize, fftBuffer.end(), 0.0f);
+        fft.performRealOnlyForwardTransform (fftBuffer.data(), true);
+
+        auto* slotReal = channelReal + spectrumSlot * numBins;
+        auto* slotImag = channelImag + spectrumSlot * numBins;
+
+        for (int bin = 0; bin <= partitionSize; ++bin)
+        {
+            slotReal[bin] = fftBuffer[(size_t) (2 * bin)];
+            slotImag[bin] = fftBuffer[(size_t) (2 * bin + 1)];
+        }
+
+        // The older half becomes the newer half's predecessor next time
+        std::copy (block + partitionSize, block + fftSize, block);
+
+        // Worked out as soon as the kernel and the history are complete, so
+        // the output is already valid on the block the convolution takes over
+        if (! isConvolutionReady())
+            continue;
+
+        // Sum of input spectra times kernel spectra, over the used partitions only
+        alignas (16) float sumReal[numBins] {};
+        alignas (16) float sumImag[numBins] {};
+
+        for (auto partition : usedPartitions)
+        {
+            auto slot = (spectrumSlot - partition + maxPartitions) % maxPartitions;
+            const auto* xRe = channelReal + slot * numBins;
+            const auto* xIm = channelImag + slot * numBins;
+            const auto* hRe = kernelReal.data() + partition * numBins;
+            const auto* hIm = kernelImag.data() + partition * numBins;
+
+            for (int bin = 0; bin < numBins; bin += 4)
+            {
+                auto re = Float4::load (xRe + bin), im = Float4::load (xIm + bin);
+                auto kernelRe = Float4::load (hRe + bin), kernelIm = Float4::load (hIm + bin);
+                (Float4::load (sumReal + bin) + re * kernelRe - im * kernelIm).store (sumReal + bin);
+                (Float4::multiplyAdd (Float4::load (sumImag + bin), re, kernelIm) + im * kernelRe).store (sumImag + bin);
+            }
+        }
+
+        for (int bin = 0; bin <= partitionSize; ++bin)
+        {
+            fftBuffer[(size_t) (2 * bin)] = sumReal[bin];
+            fftBuffer[(size_t) (2 * bin + 1)] = sumImag[bin];
+        }
+
+        fft.performRealOnlyInverseTransform (fftBuffer.data());
+
+        // Overlap-save: only the second half is free of wrap-around
+        std::copy (fftBuffer.begin() + partitionSize, fftBuffer.begin() + fftSize, outputBlocks.begin() + channel * partitionSize);
+    }
+}
+
+void MultiTapDelay::process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept
+{
+    numChannels = juce::jmin (numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelHistory = history.data() + channel * historySize;
+        auto firstPart = juce::jmin (numSamples, historySize - historyPosition);
+        std::copy (input[channel], input[channel] + firstPart, channelHistory + historyPosition);
+        std::copy (input[channel] + firstPart, input[channel] + numSamples, channelHistory);
+        juce::FloatVectorOperations::clear (output[channel], numSamples);
+    }
+
+    historyPosition = (historyPosition + numSamples) % historySize;
+
+    addTaps (taps.data(), taps.data() + numShortTaps, output, numChannels, 0, numSamples, numSamples);
+
+    if (! convolutionWanted)
+    {
+        convolutionActive = false;
+        addTaps (taps.data() + numShortTaps, taps.data() + numTaps, output, numChannels, 0, numSamples, numSamples);
+        return;
+    }
+
+    compilePartitions (partitionsPerBlock);
+
+    for (int i = 0; i < numSamples;)
+    {
+        // The paths only swap on a partition boundary, so the output stays continuous
+        if (blockPosition == 0 && ! convolutionActive && isConvolutionReady())
+            convolutionActive = true;
+
+        auto run = juce::jmin (numSamples - i, partitionSize - blockPosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            std::copy (input[channel] + i, input[channel] + i + run, inputBlocks.begin() + channel * fftSize + partitionSize + blockPosition);
+
+            if (convolutionActive)
+                juce::FloatVectorOperations::add (output[channel] + i, outputBlocks.data() + channel * partitionSize + blockPosition, run);
+        }
+
+        if (! convolutionActive)
+            addTaps (taps.data() + numShortTaps, taps.data() + numTaps, output, numChannels, i, run, numSamples);
+
+        blockPosition += run;
+        i += run;
+
+        if (blockPosition == partitionSize)
+        {
+            blockPosition = 0;
+            convolveBlock (numChannels);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    MultiTapDelay.h
+    A static pattern of taps, evaluated tap by tap or by partitioned convolution.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    Plays a fixed set of taps (delay and gain, no feedback) over the input.
+
+    Taps shorter than one partition are always added in the time domain. The
+    rest are either added the same way, one vector pass per tap, or compiled
+    into a uniformly partitioned FIR and run by FFT convolution. Partitions
+    without a tap are skipped, so a sparse pattern only pays for the
+    partitions it uses. Which way is cheaper is decided per pattern from
+    costs measured once when the first instance is prepared.
+
+    The convolution adds one partition of latency. The FIR is shifted forward
+    by one partition to cancel that out, which is why short taps stay in the
+    time domain.
+
+    A new pattern is compiled a few partitions per block. Until it is complete,
+    and the convolution has a full history behind it, the time domain path
+    carries on.
+*/
+class MultiTapDelay
+{
+public:
+    static constexpr int maxTaps = 64;
+    static constexpr int maxChannels = 2;
+    static constexpr int partitionSize = 256;
+
+    void prepare (double sampleRate, int maxDelayInSamples, int maximumBlockSize);
+    void reset();
+
+    /** Replaces the pattern. Does nothing if it's the same as the current one. */
+    void setPattern (const float* delaysInSamples, const float* gains, int numTaps);
+
+    /** Writes the taps of input into output. They must be separate buffers. */
+    void process (const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+    bool isUsingConvolution() const noexcept     { return convolutionActive; }
+
+private:
+    struct Tap
+    {
+        int delay = 0;
+        float gain = 0.0f;
+    };
+
+    /** Seconds per tap per sample, per FFT, and per partition multiply-add. */
+    struct Costs
+    {
+        double tap = 0.0, fft = 0.0, partition = 0.0;
+    };
+
+    static Costs measureCosts();
+
+    void compilePartitions (int count) noexcept;
+    void addTaps (const Tap* first, const Tap* last, float* const* output, int numChannels,
+                  int startSample, int numSamples, int blockLength) const noexcept;
+
+    bool isConvolutionReady() const noexcept
+    {
+        return compiledPartitions == (int) usedPartitions.size() && blocksFed > numPartitions;
+    }
+    void convolveBlock (int numChannels) noexcept;
+
+    static constexpr int fftSize = 2 * partitionSize;
+    static constexpr int numBins = partitionSize + 4;   // partitionSize + 1, padded for Float4
+    static constexpr int partitionsPerBlock = 8;
+
+    juce::dsp::FFT fft { juce::roundToInt (std::log2 (fftSize)) };
+    Costs costs;
+
+    std::array<Tap, maxTaps> taps {};
+    int numTaps = 0, numShortTaps = 0;
+
+    // Input history for the time domain path
+    std::vector<float> history;
+    int maxDelay = 0;
+    int historySize = 0;
+    int historyPosition = 0;
+
+    // Kernel spectra, split into real and imaginary planes, and the frequency
+    // domain delay line of input spectra, per channel
+    std::vector<float> kernelReal, kernelImag;
+    std::vector<float> inputReal, inputImag;
+    std::vector<int> usedPartitions;
+    int maxPartitions = 0, numPartitions = 0, compiledPartitions = 0;
+    int spectrumSlot = 0;
+    int blocksFed = 0;
+    bool convolutionWanted = false, convolutionActive = false;
+
+    // Per channel: the last two input partitions, and the output of the last block
+    std::vector<float> inputBlocks, outputBlocks;
+    std::vector<float> fftBuffer;
+    int blockPosition = 0;
+};
@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    NoiseGenerator.cpp
+    Block-filling white noise from parallel xorshift generators.
+
+  ==============================================================================
+*/
+
+#include "NoiseGenerator.h"
+
+//==============================================================================
+NoiseGenerator::NoiseGenerator()
+{
+    // Each instance starts somewhere different, so stereo pairs and multiple
+    // instances don't hiss in unison
+    seed (juce::Random::getSystemRandom().nextInt64());
+}
+
+void NoiseGenerator::seed (juce::int64 seedValue) noexcept
+{
+    // An LCG step between lanes spreads one seed over all four; xorshift never
+    // leaves a zero state, so the low bit is forced on
+    auto x = (uint64_t) seedValue;
+
+    for (auto& lane : state)
+    {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        lane = (uint32_t) (x >> 32) | 1u;
+    }
+}
+
+void NoiseGenerator::fill (float* destination, int numSamples) noexcept
+{
+    constexpr float scale = 1.0f / 2147483648.0f;
+    auto lanes = state;
+    int i = 0;
+
+    for (; i + numLanes <= numSamples; i += numLanes)
+    {
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            auto x = lanes[(size_t) lane];
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            lanes[(size_t) lane] = x;
+            destination[i + lane] = (float) (int32_t) x * scale;
+        }
+    }
+
+    for (int lane = 0; i < numSamples; ++i, ++lane)
+    {
+        auto x = lanes[(size_t) lane];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        lanes[(size_t) lane] = x;
+        destination[i] = (float) (int32_t) x * scale;
+    }
+
+    state = lanes;
+}
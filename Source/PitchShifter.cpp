@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    PitchShifter.cpp
+    Two-grain octave shifter for shimmer in the feedback path.
+
+  ==============================================================================
+*/
+
+#include "PitchShifter.h"
+
+//==============================================================================
+void PitchShifter::prepare (double sampleRate)
+{
+    auto newWindowLength = (float) juce::roundToInt (windowMilliseconds * 0.001 * sampleRate);
+
+    // The ring only needs rebuilding when the grain length changes
+    if (newWindowLength == windowLength && ! ring.empty())
+        return;
+
+    windowLength = newWindowLength;
+
+    // The longest read is the window plus the two samples the interpolation
+    // and the minimum delay need; a power of two so wrapping is a mask
+    auto size = (int) juce::nextPowerOfTwo ((int) windowLength + 4);
+    ring.assign ((size_t) (size * maxChannels), 0.0f);
+    ringMask = size - 1;
+
+    // sin^2 over one grain: the two heads are half a grain apart, so their
+    // gains always add up to one. The extra entry saves a wrap in the lookup
+    for (int i = 0; i <= windowTableSize; ++i)
+    {
+        auto s = std::sin (juce::MathConstants<double>::pi * i / windowTableSize);
+        window[(size_t) i] = (float) (s * s);
+    }
+
+    setParameters (rising ? Interval::octaveUp : Interval::octaveDown, shiftAmount);
+    reset();
+}
+
+void PitchShifter::reset()
+{
+    std::fill (ring.begin(), ring.end(), 0.0f);
+    writePosition = 0;
+    phase = 0.0f;
+}
+
+void PitchShifter::setParameters (Interval interval, float amount)
+{
+    // A head reading at a delay that changes by (1 - ratio) per sample plays
+    // back at ratio times the speed. An octave up shrinks the delay by one
+    // sample per sample, an octave down grows it by half a sample
+    auto ratio = interval == Interval::octaveUp ? 2.0f : 0.5f;
+    rising = interval == Interval::octaveUp;
+    phaseIncrement = windowLength > 0.0f ? std::abs (ratio - 1.0f) / windowLength : 0.0f;
+    shiftAmount = juce::jlimit (0.0f, 1.0f, amount);
+}
+
+Float4 PitchShifter::process (Float4 input) noexcept
+{
+    auto* data = ring.data();
+    input.store (data + writePosition * maxChannels);
+
+    auto shifted = Float4::broadcast (0.0f);
+
+    for (int head = 0; head < 2; ++head)
+    {
+        auto headPhase = phase + 0.5f * (float) head;
+
+        if (headPhase >= 1.0f)
+            headPhase -= 1.0f;
+
+        // At least one sample behind the write head, so the newer of the two
+        // interpolated samples has always been written
+        auto delay = 1.0f + (rising ? 1.0f - headPhase : headPhase) * windowLength;
+        auto integerDelay = (int) delay;
+        auto fraction = Float4::broadcast (delay - (float) integerDelay);
+
+        auto newer = Float4::load (data + ((writePosition - integerDelay) & ringMask) * maxChannels);
+        auto older = Float4::load (data + ((writePosition - integerDelay - 1) & ringMask) * maxChannels);
+        auto sample = Float4::multiplyAdd (newer, older - newer, fraction);
+
+        auto windowPosition = headPhase * (float) windowTableSize;
+        auto windowIndex = (int) windowPosition;
+        auto w0 = window[(size_t) windowIndex];
+        auto gain = w0 + (window[(size_t) windowIndex + 1] - w0) * (windowPosition - (float) windowIndex);
+
+        shifted = Float4::multiplyAdd (shifted, sample, Float4::broadcast (gain));
+    }
+
+    phase += phaseIncrement;
+
+    if (phase >= 1.0f)
+        phase -= 1.0f;
+
+    writePosition = (writePosition + 1) & ringMask;
+
+    return Float4::multiplyAdd (input, shifted - input, Float4::broadcast (shiftAmount));
+}
+
+void PitchShifter::processFrame (float* frame) noexcept
+{
+    if (ring.empty())
+        return;
+
+    process (Float4::load (frame)).store (frame);
+}
+
+void PitchShifter::processChannels (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (ring.empty())
+        return;
+
+    numChannels = juce::jmin (numChannels, maxChannels);
+    alignas (16) float frame[maxChannels] = {};
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = channels[channel][i];
+
+        process (Float4::load (frame)).store (frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel][i] = frame[channel];
+    }
+}
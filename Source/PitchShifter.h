@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    PitchShifter.h
+    Two-grain octave shifter for shimmer in the feedback path.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDVector.h"
+
+//==============================================================================
+/**
+    A delay-line pitch shifter. Two read heads sweep across a short window of
+    the signal's recent past at the rate that gives the wanted interval, half
+    a window apart, and each is faded in and out with a raised cosine so that
+    one always covers the other's jump back to the start.
+
+    The cost is fixed: four Float4 loads and two window lookups per sample,
+    whatever the interval. All channels share one interleaved ring, so a
+    single load fetches a sample for every channel.
+*/
+class PitchShifter
+{
+public:
+    static constexpr int maxChannels = 4;
+
+    enum class Interval
+    {
+        octaveUp = 0,
+        octaveDown
+    };
+
+    void prepare (double sampleRate);
+    void reset();
+
+    /** Sets the interval and how much of the shifted signal replaces the
+        original, from 0 to 1.
+    */
+    void setParameters (Interval interval, float amount);
+
+    /** Shifts one frame in place. The frame must hold maxChannels floats. */
+    void processFrame (float* frame) noexcept;
+
+    /** Shifts a block of separate channel buffers in place. */
+    void processChannels (float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    Float4 process (Float4 input) noexcept;
+
+    static constexpr int windowTableSize = 512;
+    static constexpr float windowMilliseconds = 40.0f;
+
+    std::vector<float> ring;
+    int ringMask = 0;
+    int writePosition = 0;
+
+    std::array<float, windowTableSize + 1> window {};
+    float windowLength = 0.0f;
+    float phase = 0.0f, phaseIncrement = 0.0f;
+    bool rising = true;
+    float shiftAmount = 0.0f;
+};
@@ -8,7 +8,9 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "SIMDVector.h"
 #include <math.h>
+#include <numeric>
 
 
 //==============================================================================
@@ -18,6 +20,7 @@ TutorialADCAudioProcessor::TutorialADCAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -28,9 +31,60 @@ TutorialADCAudioProcessor::TutorialADCAudioProcessor()
     std::make_unique<juce::AudioParameterFloat> ( "feedback", "Feedback", 0.0f, 1.0f, 0.35f),
     std::make_unique<juce::AudioParameterFloat> ( "mix", "Dry / Mix", 0.0f, 1.0f, 0.5f),
     std::make_unique<juce::AudioParameterFloat>   ( "time", "Time", 0.004f, 2.0f, 0.300f),
+    std::make_unique<juce::AudioParameterBool> ( "sync", "Tempo Sync", false),
+    std::make_unique<juce::AudioParameterChoice> ( "syncDivision", "Sync Division", juce::StringArray { "1/32", "1/16", "1/8", "1/4", "1/2", "1/1" }, 2),
+    std::make_unique<juce::AudioParameterChoice> ( "syncModifier", "Sync Modifier", juce::StringArray { "Straight", "Dotted", "Triplet" }, 0),
+    std::make_unique<juce::AudioParameterBool> ( "midiControl", "MIDI Control", false),
     std::make_unique<juce::AudioParameterBool> ( "toggle", "On / Off", true),
+    std::make_unique<juce::AudioParameterBool> ( "retime", "Tape Re-time", false),
+    std::make_unique<juce::AudioParameterBool> ( "freeze", "Freeze", false),
+    std::make_unique<juce::AudioParameterChoice> ( "mode", "Mode", juce::StringArray { "Digital", "Tape", "Crossfade", "Reverb", "Reverse", "Granular", "Spectral", "Multi-Tap", "Resonator", "Lo-Fi", "BBD" }, 0),
+    std::make_unique<juce::AudioParameterFloat> ( "lowCut", "Low Cut", juce::NormalisableRange<float> (FeedbackFilter::minLowCut, 2000.0f, 0.0f, 0.3f), FeedbackFilter::minLowCut),
+    std::make_unique<juce::AudioParameterFloat> ( "highCut", "High Cut", juce::NormalisableRange<float> (1000.0f, FeedbackFilter::maxHighCut, 0.0f, 0.3f), FeedbackFilter::maxHighCut),
+    std::make_unique<juce::AudioParameterFloat> ( "wow", "Wow", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "flutter", "Flutter", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "tapeHiss", "Tape Hiss", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterChoice> ( "filterSlope", "Filter Slope", juce::StringArray { "6 dB/oct", "12 dB/oct" }, 1),
+    std::make_unique<juce::AudioParameterChoice> ( "saturation", "Saturation", juce::StringArray { "Off", "2x", "4x" }, 0),
+    std::make_unique<juce::AudioParameterFloat> ( "drive", "Drive", 1.0f, 8.0f, 2.0f),
+    std::make_unique<juce::AudioParameterChoice> ( "routing", "Routing", juce::StringArray { "Normal", "Ping-Pong", "Cross-Feed", "Rotate", "Mid/Side" }, 0),
+    std::make_unique<juce::AudioParameterFloat> ( "routingAmount", "Routing Amount", 0.0f, 1.0f, 0.5f),
+    std::make_unique<juce::AudioParameterChoice> ( "shimmer", "Shimmer", juce::StringArray { "Off", "Octave Up", "Octave Down" }, 0),
+    std::make_unique<juce::AudioParameterFloat> ( "shimmerAmount", "Shimmer Amount", 0.0f, 1.0f, 0.5f),
+    std::make_unique<juce::AudioParameterFloat> ( "modDepth", "Mod Depth", 0.0f, 10.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "modRate", "Mod Rate", juce::NormalisableRange<float> (0.05f, 10.0f, 0.0f, 0.4f), 0.5f),
+    std::make_unique<juce::AudioParameterChoice> ( "modShape", "Mod Shape", juce::StringArray { "Sine", "Triangle", "Random" }, 0),
+    std::make_unique<juce::AudioParameterChoice> ( "diffusion", "Diffusion", juce::StringArray { "Off", "Input", "Feedback" }, 0),
+    std::make_unique<juce::AudioParameterInt> ( "diffusionStages", "Diffusion Stages", 4, AllpassDiffuser::maxStages, 4),
+    std::make_unique<juce::AudioParameterFloat> ( "diffusionAmount", "Diffusion Amount", 0.0f, 1.0f, 0.5f),
+    std::make_unique<juce::AudioParameterFloat> ( "duckAmount", "Ducking", 0.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "duckThreshold", "Duck Threshold", -60.0f, 0.0f, -24.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "duckAttack", "Duck Attack", juce::NormalisableRange<float> (0.1f, 100.0f, 0.0f, 0.4f), 5.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "duckRelease", "Duck Release", juce::NormalisableRange<float> (10.0f, 2000.0f, 0.0f, 0.4f), 250.0f),
+    std::make_unique<juce::AudioParameterChoice> ( "duckSource", "Duck Source", juce::StringArray { "Input", "Sidechain" }, 0),
+    std::make_unique<juce::AudioParameterChoice> ( "duckDetector", "Duck Detector", juce::StringArray { "Peak", "RMS" }, 0),
+    std::make_unique<juce::AudioParameterChoice> ( "reverbLines", "Reverb Lines", juce::StringArray { "8 Lines", "16 Lines" }, 0),
+    std::make_unique<juce::AudioParameterFloat> ( "reverbSize", "Reverb Size", 0.0f, 1.0f, 0.5f),
+    std::make_unique<juce::AudioParameterFloat> ( "reverbDecay", "Reverb Decay", juce::NormalisableRange<float> (FdnReverb::minDecaySeconds, FdnReverb::maxDecaySeconds, 0.0f, 0.3f), 2.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "reverbDamping", "Reverb Damping", juce::NormalisableRange<float> (1000.0f, 20000.0f, 0.0f, 0.3f), 8000.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "grainSize", "Grain Size", juce::NormalisableRange<float> (10.0f, 500.0f, 0.0f, 0.5f), 80.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "grainDensity", "Grain Density", juce::NormalisableRange<float> (1.0f, 200.0f, 0.0f, 0.4f), 20.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "grainPitch", "Grain Pitch", -12.0f, 12.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "grainSpread", "Grain Spread", 0.0f, 1.0f, 0.3f),
+    std::make_unique<juce::AudioParameterFloat> ( "spectralTilt", "Spectral Time Tilt", -1.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "spectralFeedbackTilt", "Spectral Feedback Tilt", -1.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterInt> ( "tapCount", "Taps", 1, MultiTapDelay::maxTaps, 8),
+    std::make_unique<juce::AudioParameterFloat> ( "tapSpacing", "Tap Spacing", -1.0f, 1.0f, 0.0f),
+    std::make_unique<juce::AudioParameterFloat> ( "tapDecay", "Tap Decay", 0.0f, 1.0f, 0.3f),
+    std::make_unique<juce::AudioParameterInt> ( "resonatorNote", "Resonator Note", 24, 108, 57),
+    std::make_unique<juce::AudioParameterFloat> ( "resonatorDecay", "Resonator Decay", juce::NormalisableRange<float> (0.05f, 10.0f, 0.0f, 0.4f), 1.5f),
+    std::make_unique<juce::AudioParameterFloat> ( "resonatorDamping", "Resonator Damping", 0.0f, 1.0f, 0.3f),
+    std::make_unique<juce::AudioParameterChoice> ( "lofiRate", "Lo-Fi Rate", juce::StringArray { "1/2", "1/4" }, 0),
+    std::make_unique<juce::AudioParameterChoice> ( "quality", "Interpolation", juce::StringArray { "Cubic", "Sinc" }, 0),
 })
 {
+    // Built once here rather than on first use, and shared with every other instance
+    sincTable = WindowedSincTable::getShared(sincTaps, sincPhases);
 }
 
 TutorialADCAudioProcessor::~TutorialADCAudioProcessor()
@@ -104,16 +158,102 @@ void TutorialADCAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    delayMaxSamples = (int) std::round(sampleRate * maxDelay);
-    delayBuffer.setSize(2, delayMaxSamples);
-    delayBuffer.clear();
+    auto newMaxSamples = (int) std::round(sampleRate * maxDelay);
+
+    // Many hosts call this on every transport start, so the delay memory is only
+    // touched when the sample rate really changed. A rate change converts the
+    // existing echoes instead of wiping them.
+    if (preparedSampleRate > 0.0 && sampleRate != preparedSampleRate && delayMaxSamples > 0)
+    {
+        convertHistoryToSampleRate(sampleRate, newMaxSamples);
+    }
+    else if (newMaxSamples != delayMaxSamples)
+    {
+        delayBuffer.setSize(2, newMaxSamples + guardSamples);
+        delayBuffer.clear();
+        writeHeadBuffer.assign(2, 0);
+    }
+
+    delayMaxSamples = newMaxSamples;
+    preparedSampleRate = sampleRate;
+    retimeActive = false;
+    refreshGuardZone();
     globalSampleRate = (float) sampleRate;
     writeHeadBuffer.resize(2);
     readHeadBuffer.resize(samplesPerBlock);
     timeSmoothed.reset(sampleRate, 0.01f);
     timeSmoothed.setCurrentAndTargetValue (state.getParameter("time")->getValue());
+    syncBpm = 0.0;
+    syncRampedDelay = -1.0f;
+
+    // Room for a dense block's worth of events, so splitting never allocates
+    midiBlockSection.ensureSize(2048);
+    midiEventSection.ensureSize(2048);
+    lastClockSample = -1;
+    clockInterval = 0.0;
+    midiClockBpm = 0.0;
     delaySizeBuffer.resize(samplesPerBlock);
+    readSpeedBuffer.resize(samplesPerBlock);
+    tapeGlideCoefficient = 1.0f - std::exp(-1.0f / (tapeGlideSeconds * globalSampleRate));
+
+    crossfadeHeads.setSize(4, samplesPerBlock);
+    crossfadeGainBuffer.resize((size_t) samplesPerBlock);
+    crossfadeTable.resize((size_t) juce::jmax(1, juce::roundToInt(crossfadeSeconds * sampleRate)));
+
+    // Raised-cosine fade-in; the outgoing head gets the complement
+    for (size_t i = 0; i < crossfadeTable.size(); ++i)
+        crossfadeTable[i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::pi * (float) (i + 1) / (float) crossfadeTable.size());
+
+    crossfadePosition = -1;
+
+    // Hann window for the reverse chunks; two of them half a chunk apart add up to one
+    reverseWindow.resize(reverseWindowSize + 1);
+
+    for (int i = 0; i <= reverseWindowSize; ++i)
+        reverseWindow[(size_t) i] = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float) i / (float) reverseWindowSize);
+
+    reverseHeadsValid = false;
+    freezeActive = false;
     currentTimeInSamples = 0.3f * delayMaxSamples;
+
+    feedbackFilter.prepare(sampleRate);
+    reverb.prepare(sampleRate);
+
+    for (auto& channelDelay : spectralDelays)
+        channelDelay.prepare(sampleRate, maxDelay);
+
+    multiTap.prepare(sampleRate, newMaxSamples, samplesPerBlock);
+    resonator.prepare(sampleRate);
+    bucketBrigade.prepare(sampleRate);
+    tapeWobble.prepare(sampleRate, samplesPerBlock);
+    rateReducer.reset();
+    lofiRingLength = 0;
+    shimmer.prepare(sampleRate);
+
+    diffuser.prepare(sampleRate);
+    grains.prepare();
+    duckFollower.prepare(sampleRate, samplesPerBlock);
+    duckGainBuffer.resize((size_t) samplesPerBlock);
+    grainCountdown = 0.0f;
+    activeGrainCount = 0;
+    diffusedInput.setSize(2, samplesPerBlock);
+
+    preparedBlockSize = samplesPerBlock;
+    modulationBuffer.setSize(2, samplesPerBlock);
+    modulatedReads.setSize(2, samplesPerBlock);
+
+    for (auto& lfo : lfos)
+        lfo.prepare(sampleRate);
+
+    // A quarter cycle apart, so a stereo chorus spreads out
+    lfos[1].setPhaseOffset(0.25f);
+
+    saturator.setOversampling(static_cast<FeedbackSaturator::Oversampling>(static_cast<juce::AudioParameterChoice*>(state.getParameter("saturation"))->getIndex()));
+    saturator.reset();
+    latencyBuffer.setSize(2, maxLatencySamples);
+    latencyBuffer.clear();
+    latencyPosition = 0;
+    dryDelaySamples = 0;
     
 }
 
@@ -142,6 +282,17 @@ bool TutorialADCAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+
+    // The sidechain is optional, and can be mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -162,115 +313,1750 @@ float cubicInterpolation(float y0, float y1, float y2, float y3, float mu) {
     return (a0 * mu * mu2 + a1 * mu2 + a2 * mu + a3);
 }
 
+// The same polynomial as cubicInterpolation, expanded into one weight per input
+// sample so a whole set of fractional positions can be precomputed.
+void cubicInterpolationWeights(float mu, float* weights) {
+    float mu2 = mu * mu;
+    float mu3 = mu2 * mu;
+
+    weights[0] = -mu3 + 2.0f * mu2 - mu;
+    weights[1] = mu3 - 2.0f * mu2 + 1.0f;
+    weights[2] = -mu3 + mu2 + mu;
+    weights[3] = mu3 - mu2;
+}
+
+float TutorialADCAudioProcessor::interpolateSample(int channel, float readIndex, float mu)
+{
+    // readIndex is the wrapped integer position, mu the fraction towards the next sample
+    auto index = static_cast<int>(readIndex);
+    const auto* data = delayBuffer.getReadPointer(channel);
+
+    if (useSincInterpolation)
+    {
+        int numTaps = sincTable->getNumTaps();
+        int firstTap = index - sincTable->getTapsBefore();
+
+        if (firstTap >= 0 && firstTap + numTaps <= delayMaxSamples)
+            return sincTable->interpolate(data + firstTap, mu);
+
+        // The kernel straddles the end of the ring, so gather it into one piece first
+        float taps[sincTaps];
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            taps[tap] = data[(firstTap + tap + delayMaxSamples) % delayMaxSamples];
+
+        return sincTable->interpolate(taps, mu);
+    }
+
+    return cubicInterpolation(data[(index - 1 + delayMaxSamples) % delayMaxSamples],
+                              data[index],
+                              data[(index + 1) % delayMaxSamples],
+                              data[(index + 2) % delayMaxSamples],
+                              mu);
+}
+
+void TutorialADCAudioProcessor::interpolateSamples (int channel, const float* readPositions, float* destination, int numSamples) const
+{
+    // Cubic reads at many fractional positions at once. Each read needs the four
+    // samples from index - 1 onwards; the guard zone past the end of the ring
+    // mirrors its start, so those four are always contiguous once index - 1 has
+    // been wrapped.
+    const auto* data = delayBuffer.getReadPointer(channel);
+    int i = 0;
+
+   #if defined (__AVX2__)
+    const auto one = _mm256_set1_epi32(1);
+    const auto ringSize = _mm256_set1_epi32(delayMaxSamples);
+
+    for (; i + 8 <= numSamples; i += 8)
+    {
+        auto position = _mm256_loadu_ps(readPositions + i);
+        auto index = _mm256_floor_ps(position);
+        auto mu = _mm256_sub_ps(position, index);
+
+        auto base = _mm256_sub_epi32(_mm256_cvttps_epi32(index), one);
+        base = _mm256_add_epi32(base, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), base), ringSize));
+
+        auto y0 = _mm256_i32gather_ps(data, base, 4);
+        auto y1 = _mm256_i32gather_ps(data + 1, base, 4);
+        auto y2 = _mm256_i32gather_ps(data + 2, base, 4);
+        auto y3 = _mm256_i32gather_ps(data + 3, base, 4);
+
+        // Same polynomial as cubicInterpolation, in Horner form
+        auto a0 = _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(y3, y2), y1), y0);
+        auto a1 = _mm256_sub_ps(_mm256_sub_ps(y0, y1), a0);
+        auto a2 = _mm256_sub_ps(y2, y0);
+        auto result = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a0, mu), a1), mu), a2), mu), y1);
+
+        _mm256_storeu_ps(destination + i, result);
+    }
+   #endif
+
+    for (; i + 4 <= numSamples; i += 4)
+    {
+        float fractions[4];
+        int bases[4];
+
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            int index = static_cast<int>(readPositions[i + lane]);
+            fractions[lane] = readPositions[i + lane] - index;
+            bases[lane] = index == 0 ? delayMaxSamples - 1 : index - 1;
+        }
+
+        // Four contiguous loads, one per read, then a transpose so each vector
+        // holds the same tap for all four reads
+        auto y0 = Float4::load(data + bases[0]);
+        auto y1 = Float4::load(data + bases[1]);
+        auto y2 = Float4::load(data + bases[2]);
+        auto y3 = Float4::load(data + bases[3]);
+        Float4::transpose(y0, y1, y2, y3);
+
+        auto mu = Float4::load(fractions);
+        auto a0 = y3 - y2 - y0 + y1;
+        auto a1 = y0 - y1 - a0;
+        auto a2 = y2 - y0;
+        auto result = Float4::multiplyAdd(y1, Float4::multiplyAdd(a2, Float4::multiplyAdd(a1, a0, mu), mu), mu);
+        result.store(destination + i);
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        int index = static_cast<int>(readPositions[i]);
+        const auto* taps = data + (index == 0 ? delayMaxSamples - 1 : index - 1);
+        destination[i] = cubicInterpolation(taps[0], taps[1], taps[2], taps[3], readPositions[i] - index);
+    }
+}
+
+void TutorialADCAudioProcessor::refreshGuardZone()
+{
+    for (int channel = 0; channel < delayBuffer.getNumChannels(); ++channel)
+    {
+        auto* data = delayBuffer.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(data + delayMaxSamples, data, guardSamples);
+    }
+}
+
 void TutorialADCAudioProcessor::resampleBuffer (int initialSampleSize, int targetSampleSize)
 {
-    
-    // Check for valid sample sizes and ensure initialSampleSize > targetSampleSize
-    if (initialSampleSize <= 0 || targetSampleSize <= 0 || initialSampleSize <= targetSampleSize) {
-        // Handle error: Invalid sample sizes
+    // Starts re-timing the last initialSampleSize samples of history so that they
+    // fill targetSampleSize samples instead. The actual work is done in slices by
+    // advanceResample so that no single callback pays for the whole history.
+    if (initialSampleSize <= 1 || targetSampleSize <= 1 || initialSampleSize == targetSampleSize)
+        return;
+
+    // The span is anchored where the write head was when the job started, and
+    // new input lands after that point. The write head moves at most a block
+    // per slice, so the span is kept short enough that it can't wrap round
+    // into it before the job is done.
+    double blocksPerSample = (double) preparedBlockSize / retimeSamplesPerBlock;
+    int longestSpan = (int) ((delayMaxSamples - sincTaps - preparedBlockSize - retimePendingSize) / (1.0 + blocksPerSample));
+
+    retimeSourceSize = juce::jmin(initialSampleSize, longestSpan);
+    retimeTargetSize = juce::jmin(targetSampleSize, longestSpan);
+    retimeProgress = 0;
+
+    if (retimeSourceSize <= 1 || retimeTargetSize <= 1 || retimeSourceSize == retimeTargetSize)
+        return;
+
+    for (int channel = 0; channel < 2; ++channel)
+        retimeEnd[channel] = writeHeadBuffer[channel];
+
+    retimeActive = true;
+}
+
+void TutorialADCAudioProcessor::advanceResample (int maxSamples)
+{
+    if (! retimeActive)
         return;
+
+    int count = juce::jmin(maxSamples, retimeTargetSize - retimeProgress);
+    double ratio = static_cast<double>(retimeSourceSize - 1) / static_cast<double>(retimeTargetSize - 1);
+
+    // The job runs in place. Compressing walks from the newest sample backwards and
+    // stretching walks forwards, so the reads stay ahead of the writes. Near the
+    // end of the span they close in to within a kernel's width, so each write
+    // is held back by retimePendingSize steps.
+    bool compressing = retimeTargetSize < retimeSourceSize;
+
+    auto writeStep = [this, compressing] (int channel, int step, float value)
+    {
+        int n = compressing ? retimeTargetSize - 1 - step : step;
+        int writeIndex = (retimeEnd[channel] - retimeTargetSize + n + delayMaxSamples) % delayMaxSamples;
+        delayBuffer.setSample(channel, writeIndex, value);
+    };
+
+    // Positions are worked out a batch at a time so the reads can go through
+    // interpolateSamples. The job always uses the cubic: a sinc kernel would
+    // reach well past the span's newest sample, into input the job doesn't own.
+    constexpr int batchSize = 64;
+    float readPositions[batchSize];
+    float values[batchSize];
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        int end = retimeEnd[channel];
+
+        for (int start = 0; start < count; start += batchSize)
+        {
+            int numInBatch = juce::jmin(batchSize, count - start);
+
+            for (int i = 0; i < numInBatch; ++i)
+            {
+                int n = compressing ? retimeTargetSize - 1 - (retimeProgress + start + i) : retimeProgress + start + i;
+                double readPosition = end - retimeSourceSize + n * ratio;
+
+                if (readPosition < 0.0)
+                    readPosition += delayMaxSamples;
+
+                readPositions[i] = static_cast<float>(readPosition);
+            }
+
+            interpolateSamples(channel, readPositions, values, numInBatch);
+
+            for (int i = 0; i < numInBatch; ++i)
+            {
+                int step = retimeProgress + start + i;
+                auto& pending = retimePending[(size_t) channel][(size_t) (step % retimePendingSize)];
+
+                if (step >= retimePendingSize)
+                    writeStep(channel, step - retimePendingSize, pending);
+
+                pending = values[i];
+            }
+        }
     }
 
-    // Ensure lastWriteHead is within bounds of delay buffer
-    lastWriteHead = (lastWriteHead + delayMaxSamples) % delayMaxSamples;
-    for (int channel = 0; channel < 2; ++channel) {
-        // Calculate ratio for resampling
-        float ratio = static_cast<float>(initialSampleSize - 1) / static_cast<float>(targetSampleSize - 1);
+    retimeProgress += count;
 
-        // Calculate starting and ending read indices
-        int indexStart = (lastWriteHead - initialSampleSize + delayMaxSamples) % delayMaxSamples;
+    if (retimeProgress >= retimeTargetSize)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+            for (int step = juce::jmax(0, retimeTargetSize - retimePendingSize); step < retimeTargetSize; ++step)
+                writeStep(channel, step, retimePending[(size_t) channel][(size_t) (step % retimePendingSize)]);
+
+        retimeActive = false;
+    }
+
+    refreshGuardZone();
+}
+
+void TutorialADCAudioProcessor::convertHistoryToSampleRate (double newSampleRate, int newMaxSamples)
+{
+    // Called from prepareToPlay while the host has processing suspended, so it is
+    // allowed to allocate and take its time.
+    auto oldRate = (juce::int64) std::round(preparedSampleRate);
+    auto newRate = (juce::int64) std::round(newSampleRate);
+    auto divisor = std::gcd(oldRate, newRate);
+    auto upFactor = newRate / divisor;
+    auto downFactor = oldRate / divisor;
+
+    // Output sample n sits at input position n * downFactor / upFactor, so the
+    // fractional offsets cycle through upFactor phases. Fractional host rates can
+    // make that cycle huge, in which case the phases are quantised.
+    auto numPhases = (int) juce::jmin(upFactor, (juce::int64) 4096);
+    std::vector<std::array<float, 4>> phaseWeights ((size_t) numPhases);
 
-        // Initialize writeIndex to the starting index
-        int writeIndex = (lastWriteHead - (initialSampleSize - targetSampleSize) + delayMaxSamples) % delayMaxSamples;
+    for (int phase = 0; phase < numPhases; ++phase)
+        cubicInterpolationWeights((float) phase / (float) numPhases, phaseWeights[(size_t) phase].data());
 
-        // Perform resampling using linear interpolation
-        for (int i = 0; i < targetSampleSize; ++i) {
-            float readIndex = indexStart + i * ratio;
+    // Going down, the kernel also has to cut off below the new Nyquist, or
+    // everything above it folds back into the stored echoes. That takes a
+    // windowed sinc, longer the further the rate drops. Going up, the cubic
+    // is enough.
+    std::unique_ptr<WindowedSincTable> lowPass;
+    int kernelTaps = 4;
+    int tapsBefore = 1;
 
-            // Calculate the neighboring indices for interpolation
-            int xlow1 = static_cast<int>(std::floor(readIndex)) - 1;
-            int xlow2 = static_cast<int>(std::floor(readIndex));
-            int xhigh1 = static_cast<int>(std::ceil(readIndex));
-            int xhigh2 = static_cast<int>(std::ceil(readIndex)) + 1;
+    if (newRate < oldRate)
+    {
+        auto rateDrop = (double) oldRate / (double) newRate;
+        kernelTaps = juce::jmin(256, ((int) std::ceil(16.0 * rateDrop) + 3) / 4 * 4);
+        lowPass = std::make_unique<WindowedSincTable>(kernelTaps, numPhases, 0.45 / rateDrop);
+        tapsBefore = lowPass->getTapsBefore();
+    }
+
+    // Keep as much of the most recent history as fits in the new buffer.
+    auto historyIn = juce::jmin(delayMaxSamples - 3, (int) ((juce::int64) newMaxSamples * downFactor / upFactor));
+    auto historyOut = (int) ((juce::int64) historyIn * upFactor / downFactor);
+
+    juce::AudioBuffer<float> resampled (2, newMaxSamples + guardSamples);
+    resampled.clear();
 
-            // Wrap indices around the circular buffer
-            xlow1 = (xlow1 + delayMaxSamples) % delayMaxSamples;
-            xlow2 = (xlow2 + delayMaxSamples) % delayMaxSamples;
-            xhigh1 = (xhigh1 + delayMaxSamples) % delayMaxSamples;
-            xhigh2 = (xhigh2 + delayMaxSamples) % delayMaxSamples;
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        const auto* source = delayBuffer.getReadPointer(channel);
+        auto* destination = resampled.getWritePointer(channel);
+        int readStart = (writeHeadBuffer[channel] - historyIn + delayMaxSamples) % delayMaxSamples;
 
-            // Perform cubic interpolation
-            float ylow1 = delayBuffer.getSample(channel, xlow1);
-            float ylow2 = delayBuffer.getSample(channel, xlow2);
-            float yhigh1 = delayBuffer.getSample(channel, xhigh1);
-            float yhigh2 = delayBuffer.getSample(channel, xhigh2);
+        for (int i = 0; i < historyOut; ++i)
+        {
+            auto position = (juce::int64) i * downFactor;
+            auto index = (int) (position / upFactor);
+            auto phase = (int) ((position % upFactor) * numPhases / upFactor);
+            const float* weights = lowPass != nullptr ? lowPass->getKernel((float) phase / (float) numPhases)
+                                                      : phaseWeights[(size_t) phase].data();
 
-            float mu = (readIndex - xlow1) / (xhigh2 - xlow1);
-            float yInterpolated = cubicInterpolation(ylow1, ylow2, yhigh1, yhigh2, mu);
+            float sample = 0.0f;
 
-            // Write interpolated sample to delay buffer
-            delayBuffer.setSample(channel, writeIndex, yInterpolated);
+            for (int tap = 0; tap < kernelTaps; ++tap)
+            {
+                // Clamp to the converted span so the newest samples don't pick up
+                // the oldest ones across the ring boundary.
+                auto offset = juce::jlimit(0, historyIn - 1, index - tapsBefore + tap);
+                sample += weights[tap] * source[(readStart + offset) % delayMaxSamples];
+            }
 
-            // Move writeIndex to the next position
-            writeIndex = (writeIndex + 1) % delayMaxSamples;
+            destination[i] = sample;
         }
+
+        writeHeadBuffer[channel] = historyOut % newMaxSamples;
     }
-    
+
+    delayBuffer = std::move(resampled);
+
+    // The lengths that describe the history are in samples too, so they are
+    // scaled with it; otherwise the first block at the new rate would start a
+    // re-time or glide from a length measured at the old one
+    double ratio = (double) upFactor / (double) downFactor;
+    oldTimeInSamples = juce::jlimit(4, newMaxSamples - 1, (int) std::round(oldTimeInSamples * ratio));
+    tapeDelayInSamples = juce::jlimit(minTapeDelay, (float) (newMaxSamples - minTapeDelay), (float) (tapeDelayInSamples * ratio));
 }
 
-void TutorialADCAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+void TutorialADCAudioProcessor::updateTapeTrajectory (float targetDelay, int numSamples)
 {
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // The delay glides towards its target. Limiting the step keeps the read
+        // speed, 1 - step, between a quarter and four times real time.
+        float step = juce::jlimit(-3.0f, 0.75f, (targetDelay - tapeDelayInSamples) * tapeGlideCoefficient);
+        tapeDelayInSamples += step;
 
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+        delaySizeBuffer[(size_t) i] = tapeDelayInSamples;
+        readSpeedBuffer[(size_t) i] = 1.0f - step;
+    }
+}
 
-    float gain = state.getParameter("gain")->getValue();
-    float feedback = state.getParameter("feedback")->getValue();
-    float mix = state.getParameter("mix")->getValue();
-    float time = state.getParameter("time")->getValue(); // Use getNextValue directly for smoother updates
-    timeSmoothed.setTargetValue(time);
-    
-    int currentTimeInSamples = static_cast<int>(timeSmoothed.getNextValue() * delayMaxSamples); // Calculate current time in samples directly
+void TutorialADCAudioProcessor::updateTempoSync()
+{
+    // A running MIDI clock wins over the host's tempo. Hosts that don't
+    // report a tempo this block keep the last one they did
+    if (midiClockBpm > 0.0 && midiSampleCounter - lastClockSample < (juce::int64) preparedSampleRate)
+        hostBpm = midiClockBpm;
+    else if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto bpm = position->getBpm())
+                if (*bpm > 0.0)
+                    hostBpm = *bpm;
 
-    // Resample the delay buffer if the time parameter has changed
-    // if (oldTimeInSamples != currentTimeInSamples)
-    //     resampleBuffer(oldTimeInSamples, currentTimeInSamples);
+    int division = static_cast<juce::AudioParameterChoice*>(state.getParameter("syncDivision"))->getIndex();
+    int modifier = static_cast<juce::AudioParameterChoice*>(state.getParameter("syncModifier"))->getIndex();
 
-    oldTimeInSamples = currentTimeInSamples; // Update oldTimeInSamples
+    if (hostBpm == syncBpm && division == syncDivision && modifier == syncModifier)
+        return;
+
+    // A new note value is a jump, like turning the time knob; only tempo
+    // changes glide
+    if (division != syncDivision || modifier != syncModifier)
+        syncRampedDelay = -1.0f;
+
+    // Lengths in beats, from a 1/32 note to a whole note
+    static constexpr float divisionBeats[] = { 0.125f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+    static constexpr float modifierScale[] = { 1.0f, 1.5f, 2.0f / 3.0f };
+
+    syncBpm = hostBpm;
+    syncDivision = division;
+    syncModifier = modifier;
+
+    double seconds = divisionBeats[division] * modifierScale[modifier] * 60.0 / syncBpm;
+    syncDelayInSamples = juce::jlimit(4.0f, (float) (delayMaxSamples - 1), (float) (seconds * preparedSampleRate));
+}
+
+float TutorialADCAudioProcessor::readTapeSample (int channel, int readIndex, float fraction, float speed)
+{
+    constexpr int numTaps = VarispeedInterpolator::numTaps;
+    int firstTap = readIndex - VarispeedInterpolator::tapsBefore;
+    const auto* data = delayBuffer.getReadPointer(channel);
+
+    if (firstTap >= 0 && firstTap + numTaps <= delayMaxSamples)
+        return varispeedInterpolator->interpolate(data + firstTap, fraction, speed);
+
+    // The kernel straddles the end of the ring, so gather it into one piece first
+    float taps[numTaps];
+
+    for (int tap = 0; tap < numTaps; ++tap)
+        taps[tap] = data[(firstTap + tap + delayMaxSamples) % delayMaxSamples];
+
+    return varispeedInterpolator->interpolate(taps, fraction, speed);
+}
+
+void TutorialADCAudioProcessor::readDelaySpan (int channel, int writeIndex, int delayInSamples, float* destination, int numSamples) const
+{
+    int readIndex = (writeIndex - delayInSamples + delayMaxSamples) % delayMaxSamples;
+    int firstPart = juce::jmin(numSamples, delayMaxSamples - readIndex);
+    const auto* data = delayBuffer.getReadPointer(channel);
+
+    juce::FloatVectorOperations::copy(destination, data + readIndex, firstPart);
+    juce::FloatVectorOperations::copy(destination + firstPart, data, numSamples - firstPart);
+}
+
+void TutorialADCAudioProcessor::writeDelaySpan (int channel, int writeIndex, const float* source, int numSamples)
+{
+    int firstPart = juce::jmin(numSamples, delayMaxSamples - writeIndex);
+    auto* data = delayBuffer.getWritePointer(channel);
+
+    juce::FloatVectorOperations::copy(data + writeIndex, source, firstPart);
+    juce::FloatVectorOperations::copy(data, source + firstPart, numSamples - firstPart);
+}
+
+void TutorialADCAudioProcessor::updateFeedbackChain (int numChannels, int rateFactor)
+{
+    // rateFactor is how many host samples go by per sample of the loop. The
+    // filters are prepared at the host rate, so their cutoffs are scaled up
+    // to land in the same place at a reduced loop rate.
+    float lowCut = state.getRawParameterValue("lowCut")->load();
+    float highCut = state.getRawParameterValue("highCut")->load();
+
+    // Low-cut / high-cut inside the loop, so every repeat is filtered again
+    feedbackFilter.setParameters(lowCut * rateFactor, highCut * rateFactor,
+                                 static_cast<FeedbackFilter::Slope>(static_cast<juce::AudioParameterChoice*>(state.getParameter("filterSlope"))->getIndex()));
 
-    // Iterate over each channel
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    // Judged on the unscaled cutoffs, which are what the parameter ranges end at
+    filterActive = lowCut > FeedbackFilter::minLowCut || highCut < FeedbackFilter::maxHighCut;
+
+    feedbackMatrix.setRouting(static_cast<FeedbackMatrix::Routing>(static_cast<juce::AudioParameterChoice*>(state.getParameter("routing"))->getIndex()),
+                              state.getRawParameterValue("routingAmount")->load());
+    matrixActive = numChannels > 1 && ! feedbackMatrix.isIdentity();
+
+    // Whatever the shifter's ring held when shimmer was last on is stale by now
+    int shimmerChoice = static_cast<juce::AudioParameterChoice*>(state.getParameter("shimmer"))->getIndex();
+
+    if (shimmerChoice != shimmerSetting)
     {
-        auto* channelData = buffer.getWritePointer(channel);
-        int writeIndex = writeHeadBuffer[channel];
+        shimmer.reset();
+        shimmerSetting = shimmerChoice;
+    }
 
-        // Iterate over each sample in the buffer
-        for (int i = 0; i < buffer.getNumSamples(); ++i)
+    shimmerActive = shimmerChoice != 0;
+
+    if (shimmerActive)
+        shimmer.setParameters(static_cast<PitchShifter::Interval>(shimmerChoice - 1), state.getRawParameterValue("shimmerAmount")->load());
+
+    saturator.setOversampling(static_cast<FeedbackSaturator::Oversampling>(static_cast<juce::AudioParameterChoice*>(state.getParameter("saturation"))->getIndex()));
+    saturator.setDrive(state.getRawParameterValue("drive")->load());
+    saturatorActive = saturator.isEnabled();
+
+    // Diffusion on the input smears what goes into the loop once; in the
+    // feedback path it smears every repeat a little more than the last
+    int placement = static_cast<juce::AudioParameterChoice*>(state.getParameter("diffusion"))->getIndex();
+    diffuser.setParameters(static_cast<int>(state.getRawParameterValue("diffusionStages")->load()),
+                           0.7f * state.getRawParameterValue("diffusionAmount")->load());
+
+    if (placement != diffusionPlacement)
+    {
+        diffuser.reset();
+        diffusionPlacement = placement;
+    }
+
+    diffusionInLoop = placement == 2;
+}
+
+void TutorialADCAudioProcessor::prepareLoopInput (juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        loopInput[channel] = buffer.getReadPointer(channel);
+
+    if (diffusionPlacement == 1)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
         {
-            
-            // Get the read index based on the current time
-            int readIndex = (writeIndex - currentTimeInSamples + delayMaxSamples) % delayMaxSamples;
-            float delaySample = delayBuffer.getSample(channel, readIndex); // Get the delay sample
+            diffusedInput.copyFrom(channel, 0, buffer, channel, 0, buffer.getNumSamples());
+            loopInput[channel] = diffusedInput.getReadPointer(channel);
+        }
+
+        diffuser.processChannels(diffusedInput.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+    }
+}
+
+void TutorialADCAudioProcessor::processFeedbackChain (float* frame, float* feedbackFrame, int numChannels)
+{
+    // Everything between the read heads and the write head, for one frame.
+    // frame ends up as the wet signal and feedbackFrame as what's fed back.
+    if (filterActive)
+        feedbackFilter.processFrame(frame);
+
+    if (saturatorActive)
+        saturator.processFrame(frame);
+
+    if (diffusionInLoop)
+        diffuser.processFrame(frame, numChannels);
+
+    if (matrixActive)
+        feedbackMatrix.processFrame(frame, feedbackFrame);
+    else
+        std::copy(frame, frame + FeedbackMatrix::maxChannels, feedbackFrame);
+
+    // Only the feedback is shifted, so each repeat climbs one more octave
+    if (shimmerActive)
+        shimmer.processFrame(feedbackFrame);
+}
+
+void TutorialADCAudioProcessor::processLoopFrame (float* const* channels, int sampleIndex, int numChannels, int writeIndex,
+                                                  float* frame, float feedback, float mix, float gain)
+{
+    float feedbackFrame[FeedbackMatrix::maxChannels] = {};
+    processFeedbackChain(frame, feedbackFrame, numChannels);
+
+    float monoInput = 0.0f;
+
+    if (feedbackMatrix.routesInputToFirstChannel())
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            monoInput += loopInput[channel][sampleIndex] / numChannels;
+    }
 
-            // Update delay buffer with input sample and feedback
-            delayBuffer.setSample(channel, writeIndex, channelData[i] + (delaySample * feedback));
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float input = channels[channel][sampleIndex];
+        float delayInput = feedbackMatrix.routesInputToFirstChannel() ? (channel == 0 ? monoInput : 0.0f) : loopInput[channel][sampleIndex];
+
+        // Update delay buffer with input sample and feedback
+        delayBuffer.setSample(channel, writeIndex, delayInput + (feedbackFrame[channel] * feedback));
+
+        // Apply wet/dry mix and gain
+        float wet = duckingActive ? frame[channel] * duckGainBuffer[(size_t) sampleIndex] : frame[channel];
+        channels[channel][sampleIndex] = ((input * (1.0f - mix)) + (wet * mix)) * gain;
+    }
+}
+
+void TutorialADCAudioProcessor::processLoopBlock (float* const* channels, int startSample, int numChannels, int writeIndex,
+                                                  float* const* wet, int numSamples, float feedback, float mix, float gain)
+{
+    // The block version of processLoopFrame, for when the whole block was read
+    // from the delay line up front
+    if (filterActive)
+        feedbackFilter.processChannels(wet, numChannels, numSamples);
+
+    if (saturatorActive)
+        saturator.processChannels(wet, numChannels, numSamples);
+
+    if (diffusionInLoop)
+        diffuser.processChannels(wet, numChannels, numSamples);
+
+    float* feedbackSpans[FeedbackMatrix::maxChannels] = {};
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        feedbackSpans[channel] = crossfadeHeads.getWritePointer(channel + 2);
+
+    if (matrixActive)
+    {
+        feedbackMatrix.processChannels(wet, feedbackSpans, numChannels, numSamples);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(feedbackSpans[channel], feedback, numSamples);
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::copyWithMultiply(feedbackSpans[channel], wet[channel], feedback, numSamples);
+    }
+
+    if (shimmerActive)
+        shimmer.processChannels(feedbackSpans, numChannels, numSamples);
+
+    // Every channel's input has to go into the delay line before any of them
+    // is overwritten with the output, because ping-pong mixes them
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* input = loopInput[channel] + startSample;
+
+        if (! feedbackMatrix.routesInputToFirstChannel())
+            juce::FloatVectorOperations::add(feedbackSpans[channel], input, numSamples);
+        else
+            juce::FloatVectorOperations::addWithMultiply(feedbackSpans[0], input, 1.0f / numChannels, numSamples);
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelData = channels[channel] + startSample;
+
+        writeDelaySpan(channel, writeIndex, feedbackSpans[channel], numSamples);
+
+        if (duckingActive)
+            juce::FloatVectorOperations::multiply(wet[channel], duckGainBuffer.data() + startSample, numSamples);
+
+        juce::FloatVectorOperations::multiply(channelData, (1.0f - mix) * gain, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(channelData, wet[channel], mix * gain, numSamples);
+    }
+}
+
+void TutorialADCAudioProcessor::processCrossfade (juce::AudioBuffer<float>& buffer, int numChannels, int targetDelay, float feedback, float mix, float gain)
+{
+    // A time change spawns a second read head at the new position, and the old
+    // and new heads are crossfaded instead of gliding between them
+    if (crossfadePosition < 0 && targetDelay != crossfadeDelay)
+    {
+        crossfadeTargetDelay = targetDelay;
+        crossfadePosition = 0;
+    }
+
+    int fadeLength = (int) crossfadeTable.size();
+    int chunkSize = crossfadeHeads.getNumSamples();
+
+    for (int start = 0; start < buffer.getNumSamples(); start += chunkSize)
+    {
+        int numSamples = juce::jmin(chunkSize, buffer.getNumSamples() - start);
+        bool fading = crossfadePosition >= 0;
+
+        // Fade-in gains for the new head, shared by every channel
+        auto* fadeGains = crossfadeGainBuffer.data();
+
+        if (fading)
+        {
+            int fadeSamples = juce::jlimit(0, numSamples, fadeLength - crossfadePosition);
+            juce::FloatVectorOperations::copy(fadeGains, crossfadeTable.data() + crossfadePosition, fadeSamples);
+            juce::FloatVectorOperations::fill(fadeGains + fadeSamples, 1.0f, numSamples - fadeSamples);
+        }
+
+        // The heads can only be read as whole spans when neither of them reaches
+        // into samples that this chunk is about to write
+        int shortestDelay = fading ? juce::jmin(crossfadeDelay, crossfadeTargetDelay) : crossfadeDelay;
+        int writeIndex = writeHeadBuffer[0];
+
+        if (shortestDelay >= numSamples)
+        {
+            // Channels 0-1 of crossfadeHeads hold the blended heads, 2-3 are scratch space
+            // here and then hold the signal that is fed back
+            float* wet[FeedbackFilter::maxChannels] = {};
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                wet[channel] = crossfadeHeads.getWritePointer(channel);
+                auto* scratch = crossfadeHeads.getWritePointer(channel + 2);
+
+                readDelaySpan(channel, writeIndex, crossfadeDelay, wet[channel], numSamples);
+
+                if (fading)
+                {
+                    // wet += (newHead - wet) * fadeIn
+                    readDelaySpan(channel, writeIndex, crossfadeTargetDelay, scratch, numSamples);
+                    juce::FloatVectorOperations::subtract(scratch, wet[channel], numSamples);
+                    juce::FloatVectorOperations::addWithMultiply(wet[channel], scratch, fadeGains, numSamples);
+                }
+            }
+
+            processLoopBlock(buffer.getArrayOfWritePointers(), start, numChannels, writeIndex, wet, numSamples, feedback, mix, gain);
+        }
+        else
+        {
+            // Delays shorter than the chunk feed back within it, so go frame by frame
+            float frame[FeedbackFilter::maxChannels] = {};
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                int index = (writeIndex + i) % delayMaxSamples;
+                int readIndex = (index - crossfadeDelay + delayMaxSamples) % delayMaxSamples;
+                int newReadIndex = (index - crossfadeTargetDelay + delayMaxSamples) % delayMaxSamples;
 
-            // Apply wet/dry mix
-            channelData[i] = (channelData[i] * (1.0f - mix)) + (delaySample * mix);
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    frame[channel] = delayBuffer.getSample(channel, readIndex);
 
-            // Apply gain
-            channelData[i] *= gain;
+                    if (fading)
+                        frame[channel] += (delayBuffer.getSample(channel, newReadIndex) - frame[channel]) * fadeGains[i];
+                }
 
-            // Update write index
-            writeIndex = (writeIndex + 1) % delayMaxSamples;
+                processLoopFrame(buffer.getArrayOfWritePointers(), start + i, numChannels, index, frame, feedback, mix, gain);
+            }
         }
 
-        // Update write head buffer
-        writeHeadBuffer[channel] = writeIndex;
+        for (auto& writeHead : writeHeadBuffer)
+            writeHead = (writeIndex + numSamples) % delayMaxSamples;
+
+        if (fading)
+        {
+            crossfadePosition += numSamples;
+
+            if (crossfadePosition >= fadeLength)
+            {
+                crossfadeDelay = crossfadeTargetDelay;
+                crossfadePosition = -1;
+            }
+        }
     }
+
+    refreshGuardZone();
+}
+
+bool TutorialADCAudioProcessor::prepareModulatedReads (int numChannels, int baseDelay, const float* delays, float depth, int writeIndex, int numSamples)
+{
+    // delays, when given, is a per-sample glide that replaces baseDelay. It
+    // only ever moves one way in a block, so its shortest is at one end
+    float shortestDelay = delays != nullptr ? juce::jmin(delays[0], delays[numSamples - 1]) : (float) baseDelay;
+
+    // When every read in the block lands on samples written before it, all of
+    // them can be done up front in one batch
+    bool batched = ! useSincInterpolation && shortestDelay >= numSamples + 3;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* positions = modulationBuffer.getWritePointer(channel);
+        lfos[(size_t) channel].process(positions, numSamples);
+
+        // Turn the LFO into read positions between baseDelay and baseDelay + depth,
+        // never further back than the oldest sample the interpolator can read
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float delay = delays != nullptr ? delays[i] : (float) baseDelay;
+            float lag = juce::jmin(delay + depth * (0.5f + 0.5f * positions[i]), (float) (delayMaxSamples - 3));
+            float readPosition = std::fmod(writeIndex + i - lag, (float) delayMaxSamples);
+
+            if (readPosition < 0.0f)
+                readPosition += delayMaxSamples;
+
+            positions[i] = readPosition;
+        }
+
+        if (batched)
+            interpolateSamples(channel, positions, modulatedReads.getWritePointer(channel), numSamples);
+    }
+
+    return batched;
+}
+
+void TutorialADCAudioProcessor::delayDryInput (juce::AudioBuffer<float>& buffer, int numChannels, int latency)
+{
+    int position = latencyPosition;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelData = buffer.getWritePointer(channel);
+        auto* ring = latencyBuffer.getWritePointer(channel);
+        position = latencyPosition;
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+        {
+            std::swap(channelData[i], ring[position]);
+            position = (position + 1) % latency;
+        }
+    }
+
+    latencyPosition = position;
+}
+
+void TutorialADCAudioProcessor::readReverseSpan (int channel, int fromIndex, float* destination, int numSamples) const
+{
+    // destination[i] = delayBuffer[fromIndex - i], with the ring read forwards
+    // four samples at a time and each group flipped in a register
+    const auto* data = delayBuffer.getReadPointer(channel);
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        int position = (fromIndex - i + delayMaxSamples) % delayMaxSamples;
+        int run = juce::jmin(numSamples - i, position + 1);
+        int j = 0;
+
+        for (; j + 4 <= run; j += 4)
+            Float4::load(data + position - j - 3).reversed().store(destination + i + j);
+
+        for (; j < run; ++j)
+            destination[i + j] = data[position - j];
+
+        i += run;
+    }
+}
+
+void TutorialADCAudioProcessor::processReverse (juce::AudioBuffer<float>& buffer, int numChannels, int chunkLength, const float* chunkLengths, float feedback, float mix, float gain)
+{
+    int numSamples = buffer.getNumSamples();
+    int writeIndex = writeHeadBuffer[0];
+
+    // Two heads half a chunk apart. Each one plays the chunk that was written
+    // just before it started, backwards. A chunk that starts partway through
+    // the block takes the audio from before the block, since the block itself
+    // isn't written yet, so the whole block can be read before any of it is.
+    if (! reverseHeadsValid)
+    {
+        reverseHeads[0] = { writeIndex, 0, chunkLength };
+        reverseHeads[1] = { (writeIndex - chunkLength / 2 + delayMaxSamples) % delayMaxSamples, chunkLength / 2, chunkLength };
+        reverseHeadsValid = true;
+    }
+
+    float* wet[FeedbackFilter::maxChannels] = {};
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        wet[channel] = crossfadeHeads.getWritePointer(channel);
+        juce::FloatVectorOperations::clear(wet[channel], numSamples);
+    }
+
+    auto* windowGains = crossfadeGainBuffer.data();
+
+    for (auto& head : reverseHeads)
+    {
+        for (int i = 0; i < numSamples;)
+        {
+            if (head.position >= head.length)
+            {
+                // The chunk length follows `time` from one chunk to the next,
+                // or the synced glide at the sample the new chunk starts on
+                int length = chunkLengths != nullptr ? juce::jlimit(8, delayMaxSamples / 2, juce::roundToInt(chunkLengths[i])) : chunkLength;
+                head = { writeIndex, 0, length };
+            }
+
+            int run = juce::jmin(numSamples - i, head.length - head.position);
+            float scale = (float) reverseWindowSize / (float) head.length;
+
+            for (int j = 0; j < run; ++j)
+            {
+                float windowPosition = (float) (head.position + j) * scale;
+                int index = static_cast<int>(windowPosition);
+                windowGains[j] = reverseWindow[(size_t) index] + (windowPosition - index) * (reverseWindow[(size_t) index + 1] - reverseWindow[(size_t) index]);
+            }
+
+            int readIndex = (head.start - 1 - head.position + delayMaxSamples) % delayMaxSamples;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* chunk = crossfadeHeads.getWritePointer(channel + 2);
+                readReverseSpan(channel, readIndex, chunk, run);
+                juce::FloatVectorOperations::multiply(chunk, windowGains, run);
+                juce::FloatVectorOperations::add(wet[channel] + i, chunk, run);
+            }
+
+            head.position += run;
+            i += run;
+        }
+    }
+
+    processLoopBlock(buffer.getArrayOfWritePointers(), 0, numChannels, writeIndex, wet, numSamples, feedback, mix, gain);
+
+    for (auto& writeHead : writeHeadBuffer)
+        writeHead = (writeIndex + numSamples) % delayMaxSamples;
+
+    refreshGuardZone();
+}
+
+void TutorialADCAudioProcessor::updateDucking (juce::AudioBuffer<float>& buffer, int numChannels, float amount)
+{
+    int numSamples = buffer.getNumSamples();
+    auto* bus = getBus(true, 1);
+    bool useSidechain = static_cast<juce::AudioParameterChoice*>(state.getParameter("duckSource"))->getIndex() == 1
+                     && bus != nullptr && bus->isEnabled();
+
+    duckFollower.setParameters(static_cast<EnvelopeFollower::Detector>(static_cast<juce::AudioParameterChoice*>(state.getParameter("duckDetector"))->getIndex()),
+                               state.getRawParameterValue("duckAttack")->load(),
+                               state.getRawParameterValue("duckRelease")->load());
+
+    auto* gains = duckGainBuffer.data();
+
+    if (useSidechain)
+    {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        duckFollower.process(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), gains, numSamples);
+    }
+    else
+    {
+        duckFollower.process(buffer.getArrayOfReadPointers(), numChannels, gains, numSamples);
+    }
+
+    // The wet gain falls linearly from 1 at the threshold to 1 - amount at
+    // twice the threshold (6 dB over)
+    float threshold = juce::Decibels::decibelsToGain(state.getRawParameterValue("duckThreshold")->load());
+    juce::FloatVectorOperations::add(gains, -threshold, numSamples);
+    juce::FloatVectorOperations::multiply(gains, 1.0f / threshold, numSamples);
+    juce::FloatVectorOperations::clip(gains, gains, 0.0f, 1.0f, numSamples);
+    juce::FloatVectorOperations::multiply(gains, -amount, numSamples);
+    juce::FloatVectorOperations::add(gains, 1.0f, numSamples);
+}
+
+void TutorialADCAudioProcessor::mixEngineOutput (juce::AudioBuffer<float>& buffer, float* const* wet, int numChannels, float mix, float gain)
+{
+    // Ducks the wet signal, in place, then mixes it in with the dry
+    int numSamples = buffer.getNumSamples();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* channelData = buffer.getWritePointer(channel);
+
+        if (duckingActive)
+            juce::FloatVectorOperations::multiply(wet[channel], duckGainBuffer.data(), numSamples);
+
+        juce::FloatVectorOperations::multiply(channelData, (1.0f - mix) * gain, numSamples);
+        juce::FloatVectorOperations::addWithMultiply(channelData, wet[channel], mix * gain, numSamples);
+    }
+}
+
+void TutorialADCAudioProcessor::processFreeze (juce::AudioBuffer<float>& buffer, int numChannels, int loopLength, float mix, float gain)
+{
+    int numSamples = buffer.getNumSamples();
+    int seamLength = static_cast<int>(crossfadeTable.size());
+
+    // Capture the newest loopLength samples. Nothing is written while frozen,
+    // so the loop, and the audio just before it, stay where they are.
+    if (! freezeActive)
+    {
+        freezeLength = juce::jlimit(2 * seamLength, delayMaxSamples - seamLength - 1, loopLength);
+        freezeStart = (writeHeadBuffer[0] - freezeLength + delayMaxSamples) % delayMaxSamples;
+        freezePosition = 0;
+        freezeActive = true;
+    }
+
+    int fadeStart = freezeLength - seamLength;
+
+    for (int i = 0; i < numSamples;)
+    {
+        int run = juce::jmin(numSamples - i, freezeLength - freezePosition);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* wet = crossfadeHeads.getWritePointer(channel) + i;
+            readDelaySpan(channel, freezeStart + freezePosition, 0, wet, run);
+
+            // Towards the end of the loop, fade over to the audio that led into
+            // its start, so the wrap back to the start is seamless
+            if (freezePosition + run > fadeStart)
+            {
+                int from = juce::jmax(freezePosition, fadeStart);
+                int count = freezePosition + run - from;
+                auto* scratch = crossfadeHeads.getWritePointer(channel + 2);
+
+                readDelaySpan(channel, freezeStart + from - freezeLength, 0, scratch, count);
+                juce::FloatVectorOperations::subtract(scratch, wet + (from - freezePosition), count);
+                juce::FloatVectorOperations::addWithMultiply(wet + (from - freezePosition), scratch, crossfadeTable.data() + (from - fadeStart), count);
+            }
+        }
+
+        freezePosition += run;
+        i += run;
+
+        if (freezePosition >= freezeLength)
+            freezePosition = 0;
+    }
+
+    mixEngineOutput(buffer, crossfadeHeads.getArrayOfWritePointers(), numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::recordEngineOutput (int numChannels, int numSamples)
+{
+    // The engine modes keep their own memory, so what they play, still in
+    // crossfadeHeads, is copied into the delay line for freeze to loop
+    int writeIndex = writeHeadBuffer[0];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        writeDelaySpan(channel, writeIndex, crossfadeHeads.getReadPointer(channel), numSamples);
+
+    for (auto& writeHead : writeHeadBuffer)
+        writeHead = (writeIndex + numSamples) % delayMaxSamples;
+
+    refreshGuardZone();
+}
+
+void TutorialADCAudioProcessor::processGranular (juce::AudioBuffer<float>& buffer, int numChannels, int delayInSamples, const float* delays, float feedback, float mix, float gain)
+{
+    int numSamples = buffer.getNumSamples();
+    int writeIndex = writeHeadBuffer[0];
+    float grainLength = state.getRawParameterValue("grainSize")->load() * 0.001f * globalSampleRate;
+    float density = state.getRawParameterValue("grainDensity")->load();
+    float speed = std::pow(2.0f, state.getRawParameterValue("grainPitch")->load() / 12.0f);
+    float spread = state.getRawParameterValue("grainSpread")->load();
+
+    // Every read has to land on a sample written before this block, and a
+    // grain mustn't run past the oldest sample either
+    float minLag = juce::jmax(0.0f, (speed - 1.0f) * grainLength) + preparedBlockSize + 2.0f;
+    float maxLag = juce::jmax(minLag, delayMaxSamples - juce::jmax(0.0f, (1.0f - speed) * grainLength) - preparedBlockSize - 2.0f);
+
+    // Spawn the grains that start in this block, each one positioned as it
+    // would be at the first sample, with its start still ahead of it. With a
+    // synced glide, each grain takes the delay at the sample it starts on.
+    while (grainCountdown < numSamples)
+    {
+        float offset = grainCountdown;
+        float delay = delays != nullptr ? delays[juce::jlimit(0, numSamples - 1, static_cast<int>(offset))] : (float) delayInSamples;
+        float lag = juce::jlimit(minLag, maxLag, delay + spread * grainLength * (2.0f * grainRandom.nextFloat() - 1.0f));
+        float readPosition = writeIndex + offset - lag - offset * speed;
+
+        if (readPosition < 0.0f)
+            readPosition += delayMaxSamples;
+
+        grains.spawn(readPosition, speed, grainLength, -offset / grainLength, spread * (2.0f * grainRandom.nextFloat() - 1.0f));
+        grainCountdown += globalSampleRate / density;
+    }
+
+    grainCountdown -= numSamples;
+
+    float* wet[FeedbackFilter::maxChannels] = {};
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        wet[channel] = crossfadeHeads.getWritePointer(channel);
+        juce::FloatVectorOperations::clear(wet[channel], numSamples);
+    }
+
+    grains.process(delayBuffer.getReadPointer(0), delayBuffer.getReadPointer(numChannels > 1 ? 1 : 0), delayMaxSamples,
+                   wet[0], numChannels > 1 ? wet[1] : nullptr, numSamples);
+
+    // Roughly constant loudness however many grains overlap
+    float overlap = density * grainLength / globalSampleRate;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::multiply(wet[channel], 1.0f / std::sqrt(juce::jmax(1.0f, overlap)), numSamples);
+
+    processLoopBlock(buffer.getArrayOfWritePointers(), 0, numChannels, writeIndex, wet, numSamples, feedback, mix, gain);
+
+    for (auto& writeHead : writeHeadBuffer)
+        writeHead = (writeIndex + numSamples) % delayMaxSamples;
+
+    refreshGuardZone();
+    activeGrainCount = grains.getNumActive();
+}
+
+void TutorialADCAudioProcessor::processSpectral (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain)
+{
+    // The bands spread around the base time and feedback. A positive tilt
+    // gives the high bands the longer delays and the stronger feedback.
+    float timeTilt = state.getRawParameterValue("spectralTilt")->load();
+    float feedbackTilt = state.getRawParameterValue("spectralFeedbackTilt")->load();
+    constexpr float centreBand = 0.5f * (SpectralDelay::numBands - 1);
+
+    for (int band = 0; band < SpectralDelay::numBands; ++band)
+    {
+        float offset = (band - centreBand) / centreBand;
+        float bandDelay = delayInSamples * std::pow(2.0f, timeTilt * offset) - SpectralDelay::getLatencyInSamples();
+        float bandFeedback = feedback * juce::jlimit(0.0f, 1.0f, 1.0f + feedbackTilt * offset);
+
+        for (auto& channelDelay : spectralDelays)
+            channelDelay.setBand(band, juce::jmax(0.0f, bandDelay), bandFeedback);
+    }
+
+    int numSamples = buffer.getNumSamples();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        spectralDelays[(size_t) channel].process(buffer.getReadPointer(channel), crossfadeHeads.getWritePointer(channel), numSamples);
+
+    recordEngineOutput(numChannels, numSamples);
+
+    mixEngineOutput(buffer, crossfadeHeads.getArrayOfWritePointers(), numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::processMultiTap (juce::AudioBuffer<float>& buffer, int numChannels, float patternLength, float mix, float gain)
+{
+    // The taps fill `time`. Spacing bunches them towards the start (negative)
+    // or the end (positive), and decay makes each one quieter than the last.
+    int numTaps = static_cast<int>(state.getRawParameterValue("tapCount")->load());
+    float spacing = std::pow(4.0f, state.getRawParameterValue("tapSpacing")->load());
+    float decay = 1.0f - 0.95f * state.getRawParameterValue("tapDecay")->load();
+    float delays[MultiTapDelay::maxTaps];
+    float gains[MultiTapDelay::maxTaps];
+
+    for (int tap = 0; tap < numTaps; ++tap)
+    {
+        delays[tap] = patternLength * std::pow((tap + 1.0f) / numTaps, spacing);
+        gains[tap] = std::pow(decay, (float) tap);
+    }
+
+    multiTap.setPattern(delays, gains, numTaps);
+
+    int numSamples = buffer.getNumSamples();
+    float* wet[MultiTapDelay::maxChannels] = { crossfadeHeads.getWritePointer(0), crossfadeHeads.getWritePointer(1) };
+    multiTap.process(buffer.getArrayOfReadPointers(), wet, numChannels, numSamples);
+    recordEngineOutput(numChannels, numSamples);
+
+    mixEngineOutput(buffer, wet, numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::processResonator (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numChannels, float mix, float gain)
+{
+    int numSamples = buffer.getNumSamples();
+    float decay = state.getRawParameterValue("resonatorDecay")->load();
+    float damping = state.getRawParameterValue("resonatorDamping")->load();
+    int parameterNote = static_cast<int>(state.getRawParameterValue("resonatorNote")->load());
+
+    // The note parameter tunes the resonator until a note comes in over MIDI,
+    // and again whenever the parameter itself is moved
+    if (parameterNote != lastResonatorParameterNote)
+    {
+        lastResonatorParameterNote = parameterNote;
+        resonatorNote = parameterNote;
+    }
+
+    const float* input[CombResonator::maxChannels] = {};
+    float* wet[CombResonator::maxChannels] = {};
+
+    auto runResonator = [&] (int start, int end)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            input[channel] = buffer.getReadPointer(channel, start);
+            wet[channel] = crossfadeHeads.getWritePointer(channel) + start;
+        }
+
+        resonator.setParameters((float) juce::MidiMessage::getMidiNoteInHertz(resonatorNote), decay, damping);
+        resonator.process(input, wet, numChannels, end - start);
+    };
+
+    // Retune at each note-on, at the sample it arrives on. With MIDI control
+    // on, the freeze and clear notes belong to processBlock, not the tuning.
+    bool midiControl = state.getParameter("midiControl")->getValue() > 0.5f;
+    int position = 0;
+
+    for (const auto metadata : midiMessages)
+    {
+        auto message = metadata.getMessage();
+
+        if (! message.isNoteOn())
+            continue;
+
+        if (midiControl && (message.getNoteNumber() == midiFreezeNote || message.getNoteNumber() == midiClearNote))
+            continue;
+
+        int eventPosition = juce::jlimit(position, numSamples, metadata.samplePosition);
+        runResonator(position, eventPosition);
+        resonatorNote = message.getNoteNumber();
+        position = eventPosition;
+    }
+
+    runResonator(position, numSamples);
+    recordEngineOutput(numChannels, numSamples);
+
+    mixEngineOutput(buffer, crossfadeHeads.getArrayOfWritePointers(), numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::processLofi (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain, bool frozen)
+{
+    // The delay line, and everything in its feedback path, runs at a half or
+    // a quarter of the host rate, so it does that much less work per host
+    // sample. Half-band filters take the input down and the repeats back up.
+    rateReducer.setFactor(static_cast<RateReducer::Factor>(static_cast<juce::AudioParameterChoice*>(state.getParameter("lofiRate"))->getIndex()));
+    int factor = rateReducer.getFactor();
+
+    updateFeedbackChain(numChannels, factor);
+    prepareLoopInput(buffer, numChannels);
+
+    if (lofiRingLength != delayMaxSamples / factor)
+    {
+        // Coming from another mode or rate, the history is at the wrong rate
+        delayBuffer.clear();
+        rateReducer.reset();
+        lofiRingLength = delayMaxSamples / factor;
+        lofiWritePosition = 0;
+    }
+
+    // The filters' latency, and the saturator's at the loop rate, come off
+    // the delay, so the echoes land on time
+    int loopLatency = rateReducer.getLatencyInSamples() + (saturatorActive ? saturator.getLatencyInSamples() * factor : 0);
+    int readDelay = juce::jlimit(1, lofiRingLength - 1, juce::roundToInt((delayInSamples - loopLatency) / factor));
+
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    alignas (16) float frame[RateReducer::maxChannels] = {};
+    alignas (16) float repeats[RateReducer::maxChannels] = {};
+    float feedbackFrame[FeedbackMatrix::maxChannels] = {};
+    int writePosition = lofiWritePosition;
+
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            frame[channel] = loopInput[channel][i];
+
+        if (feedbackMatrix.routesInputToFirstChannel())
+        {
+            float monoInput = 0.0f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                monoInput += frame[channel] / numChannels;
+
+            std::fill(frame, frame + numChannels, 0.0f);
+            frame[0] = monoInput;
+        }
+
+        Float4 reduced;
+
+        if (rateReducer.push(Float4::load(frame), reduced))
+        {
+            reduced.store(frame);
+            int readIndex = writePosition - readDelay;
+
+            if (readIndex < 0)
+                readIndex += lofiRingLength;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                repeats[channel] = delayBuffer.getSample(channel, readIndex);
+
+            // Frozen, the repeats go back in untouched and nothing new joins
+            // them, so the last readDelay samples loop for as long as it's held
+            if (frozen)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    delayBuffer.setSample(channel, writePosition, repeats[channel]);
+            }
+            else
+            {
+                processFeedbackChain(repeats, feedbackFrame, numChannels);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    delayBuffer.setSample(channel, writePosition, frame[channel] + feedbackFrame[channel] * feedback);
+            }
+
+            if (++writePosition >= lofiRingLength)
+                writePosition = 0;
+
+            rateReducer.interpolate(Float4::load(repeats));
+        }
+
+        rateReducer.pull().store(frame);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float input = channels[channel][i];
+            float wet = duckingActive ? frame[channel] * duckGainBuffer[(size_t) i] : frame[channel];
+            channels[channel][i] = ((input * (1.0f - mix)) + (wet * mix)) * gain;
+        }
+    }
+
+    lofiWritePosition = writePosition;
+}
+
+void TutorialADCAudioProcessor::processReverb (juce::AudioBuffer<float>& buffer, int numChannels, float mix, float gain)
+{
+    reverb.setParameters(static_cast<FdnReverb::Lines>(static_cast<juce::AudioParameterChoice*>(state.getParameter("reverbLines"))->getIndex()),
+                         state.getRawParameterValue("reverbSize")->load(),
+                         state.getRawParameterValue("reverbDecay")->load(),
+                         state.getRawParameterValue("reverbDamping")->load());
+
+    int numSamples = buffer.getNumSamples();
+    float* wet[2] = { crossfadeHeads.getWritePointer(0), crossfadeHeads.getWritePointer(1) };
+    reverb.process(buffer.getArrayOfReadPointers(), wet, numChannels, numSamples);
+    recordEngineOutput(numChannels, numSamples);
+
+    mixEngineOutput(buffer, wet, numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::processBbd (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain)
+{
+    // The bucket brigade keeps its own stages and feedback loop
+    bucketBrigade.setParameters(delayInSamples, feedback);
+
+    int numSamples = buffer.getNumSamples();
+    float* wet[2] = { crossfadeHeads.getWritePointer(0), crossfadeHeads.getWritePointer(1) };
+    bucketBrigade.process(buffer.getArrayOfReadPointers(), wet, numChannels, numSamples);
+    recordEngineOutput(numChannels, numSamples);
+
+    mixEngineOutput(buffer, wet, numChannels, mix, gain);
+}
+
+void TutorialADCAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    // The scratch buffers are sized in prepareToPlay, so a host block that's
+    // bigger than promised is processed in pieces that fit
+    if (buffer.getNumSamples() > preparedBlockSize)
+    {
+        for (int start = 0; start < buffer.getNumSamples(); start += preparedBlockSize)
+        {
+            juce::AudioBuffer<float> section (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start,
+                                              juce::jmin(preparedBlockSize, buffer.getNumSamples() - start));
+            midiBlockSection.clear();
+            midiBlockSection.addEvents(midiMessages, start, section.getNumSamples(), -start);
+            processBlock(section, midiBlockSection);
+        }
+
+        return;
+    }
+
+    int numSamples = buffer.getNumSamples();
+
+    if (state.getParameter("midiControl")->getValue() < 0.5f)
+    {
+        midiDelayInSamples = -1.0f;
+        midiFreezeHeld = false;
+        processSection(buffer, midiMessages);
+        midiSampleCounter += numSamples;
+        return;
+    }
+
+    // Note events take effect on the sample they arrive on, so the block is
+    // processed in pieces between them. The events are read straight from
+    // the buffer's bytes, which never allocates.
+    int start = 0;
+
+    for (const auto metadata : midiMessages)
+    {
+        int position = juce::jlimit(0, numSamples, metadata.samplePosition);
+        auto status = metadata.data[0];
+
+        if (status == 0xf8)
+        {
+            handleMidiClock(midiSampleCounter + position);
+            continue;
+        }
+
+        if (status == 0xfa || status == 0xfb || status == 0xfc)
+        {
+            // Start and continue count ticks afresh; stop hands the tempo
+            // back to the host
+            lastClockSample = -1;
+
+            if (status == 0xfc)
+                midiClockBpm = clockInterval = 0.0;
+
+            continue;
+        }
+
+        auto type = status & 0xf0;
+
+        if ((type != 0x80 && type != 0x90) || metadata.numBytes < 3)
+            continue;
+
+        if (position > start)
+        {
+            processMidiSection(buffer, midiMessages, start, position);
+            start = position;
+        }
+
+        int note = metadata.data[1];
+        bool noteOn = type == 0x90 && metadata.data[2] > 0;
+
+        if (note == midiFreezeNote)
+            midiFreezeHeld = noteOn;
+        else if (note == midiClearNote && noteOn)
+            clearDelayLines();
+        else if (noteOn)
+            midiDelayInSamples = (float) (preparedSampleRate / juce::MidiMessage::getMidiNoteInHertz(note));
+    }
+
+    if (start < numSamples)
+        processMidiSection(buffer, midiMessages, start, numSamples);
+
+    midiSampleCounter += numSamples;
+}
+
+void TutorialADCAudioProcessor::processMidiSection (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int endSample)
+{
+    if (startSample == 0 && endSample == buffer.getNumSamples())
+    {
+        processSection(buffer, midiMessages);
+        return;
+    }
+
+    juce::AudioBuffer<float> section (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), startSample, endSample - startSample);
+    midiEventSection.clear();
+    midiEventSection.addEvents(midiMessages, startSample, endSample - startSample, -startSample);
+    processSection(section, midiEventSection);
+}
+
+void TutorialADCAudioProcessor::handleMidiClock (juce::int64 samplePosition)
+{
+    // 24 ticks to the beat. A gap of a second or more means the clock
+    // stopped in between, so that interval says nothing about the tempo
+    if (lastClockSample >= 0)
+    {
+        auto interval = (double) (samplePosition - lastClockSample);
+
+        if (interval > 0.0 && interval < preparedSampleRate)
+        {
+            // Ticks jitter by a few samples, so they're averaged before they
+            // become a tempo
+            clockInterval = clockInterval > 0.0 ? clockInterval + 0.1 * (interval - clockInterval) : interval;
+            midiClockBpm = 60.0 * preparedSampleRate / (24.0 * clockInterval);
+        }
+    }
+
+    lastClockSample = samplePosition;
+}
+
+void TutorialADCAudioProcessor::clearDelayLines()
+{
+    delayBuffer.clear();
+    freezeActive = false;
+    reverseHeadsValid = false;
+    crossfadePosition = -1;
+
+    reverb.reset();
+
+    for (auto& channelDelay : spectralDelays)
+        channelDelay.reset();
+
+    multiTap.reset();
+    resonator.reset();
+    rateReducer.reset();
+    bucketBrigade.reset();
+    diffuser.reset();
+    shimmer.reset();
+    grains.reset();
+    activeGrainCount = 0;
+}
+
+void TutorialADCAudioProcessor::processSection (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    float gain = state.getParameter("gain")->getValue();
+    float feedback = state.getParameter("feedback")->getValue();
+    float mix = state.getParameter("mix")->getValue();
+    float time = state.getParameter("time")->getValue(); // Use getNextValue directly for smoother updates
+
+    // Tempo sync replaces the time parameter with a note value at the host
+    // tempo. The block glides from where the last one ended rather than
+    // stepping, so tempo ramps move the read head smoothly.
+    bool syncActive = state.getParameter("sync")->getValue() > 0.5f;
+    float syncRampStart = 0.0f;
+
+    if (syncActive)
+    {
+        updateTempoSync();
+        syncRampStart = syncRampedDelay < 0.0f ? syncDelayInSamples : syncRampedDelay;
+        syncRampedDelay = syncDelayInSamples;
+        time = syncDelayInSamples / delayMaxSamples;
+        timeSmoothed.setCurrentAndTargetValue(time);
+    }
+    else
+    {
+        syncRampedDelay = -1.0f;
+    }
+
+    // The last note played with MIDI control on tunes the delay to its period
+    bool midiTimeActive = midiDelayInSamples > 0.0f;
+
+    if (midiTimeActive)
+    {
+        time = juce::jmin(1.0f, midiDelayInSamples / delayMaxSamples);
+        timeSmoothed.setCurrentAndTargetValue(time);
+    }
+
+    timeSmoothed.setTargetValue(time);
+
+    // Offline renders use the same interpolator as playback, so a bounce
+    // sounds like what was heard
+    useSincInterpolation = static_cast<juce::AudioParameterChoice*>(state.getParameter("quality"))->getIndex() == 1;
+    
+    int currentTimeInSamples = static_cast<int>(timeSmoothed.getNextValue() * delayMaxSamples); // Calculate current time in samples directly
+
+    auto mode = static_cast<DelayMode>(static_cast<juce::AudioParameterChoice*>(state.getParameter("mode"))->getIndex());
+
+    // Only these modes keep their history in delayBuffer at the full rate;
+    // lo-fi's ring and the engines' recorded output are laid out differently
+    bool fullRateDelayLine = mode == DelayMode::digital || mode == DelayMode::tape || mode == DelayMode::crossfade
+                          || mode == DelayMode::reverse || mode == DelayMode::granular;
+
+    // A job started in one mode's layout means nothing in another's
+    if (mode != retimeMode)
+    {
+        retimeActive = false;
+        retimeMode = mode;
+    }
+
+    // Tape re-time: rather than moving the read head, stretch or compress the
+    // stored history to the new time. The read head jumps straight to the new
+    // time while the history is re-timed over the following blocks.
+    if (fullRateDelayLine && state.getParameter("retime")->getValue() > 0.5f)
+    {
+        timeSmoothed.setCurrentAndTargetValue(time);
+        int requestedTimeInSamples = juce::jmax(4, static_cast<int>(time * delayMaxSamples));
+
+        // A change that arrives mid-job is picked up once the current one finishes
+        if (! retimeActive && oldTimeInSamples != requestedTimeInSamples)
+        {
+            resampleBuffer(oldTimeInSamples, requestedTimeInSamples);
+            oldTimeInSamples = requestedTimeInSamples;
+        }
+
+        advanceResample(retimeSamplesPerBlock);
+        currentTimeInSamples = oldTimeInSamples;
+    }
+
+    oldTimeInSamples = currentTimeInSamples; // Update oldTimeInSamples
+
+    // Tape mode glides the delay time per sample, which moves the read head at a
+    // varying speed and bends the pitch like a tape machine would
+    int numChannels = juce::jmin(getMainBusNumInputChannels(), delayBuffer.getNumChannels());
+
+    // Ducking turns the wet signal down while the input, or the sidechain, is loud
+    float duckAmount = state.getRawParameterValue("duckAmount")->load();
+    duckingActive = duckAmount > 0.0f;
+
+    if (duckingActive)
+        updateDucking(buffer, numChannels, duckAmount);
+
+    // Freeze holds the last `time` of audio and loops it, which needs neither
+    // writes nor feedback
+    bool freezeHeld = state.getParameter("freeze")->getValue() > 0.5f || midiFreezeHeld;
+
+    if (! freezeHeld)
+        freezeActive = false;
+
+    if (mode == DelayMode::lofi)
+    {
+        processLofi(buffer, numChannels, time * delayMaxSamples, feedback, mix, gain, freezeHeld);
+        return;
+    }
+
+    // What lo-fi mode left in the delay line is at the wrong rate for
+    // everything else
+    if (lofiRingLength != 0)
+    {
+        delayBuffer.clear();
+        lofiRingLength = 0;
+    }
+
+    // The engine modes record what they play into the delay line, so there
+    // freeze loops their output.
+    bool engineMode = mode == DelayMode::reverb || mode == DelayMode::bbd || mode == DelayMode::resonator
+                   || mode == DelayMode::multiTap || mode == DelayMode::spectral;
+
+    if (engineMode && freezeHeld)
+    {
+        processFreeze(buffer, numChannels, static_cast<int>(time * delayMaxSamples), mix, gain);
+        return;
+    }
+
+    if (mode == DelayMode::reverb)
+    {
+        processReverb(buffer, numChannels, mix, gain);
+        return;
+    }
+
+    if (mode == DelayMode::bbd)
+    {
+        processBbd(buffer, numChannels, time * delayMaxSamples, feedback, mix, gain);
+        return;
+    }
+
+    if (mode == DelayMode::resonator)
+    {
+        processResonator(buffer, midiMessages, numChannels, mix, gain);
+        return;
+    }
+
+    if (mode == DelayMode::multiTap)
+    {
+        processMultiTap(buffer, numChannels, time * delayMaxSamples, mix, gain);
+        return;
+    }
+
+    if (mode == DelayMode::spectral)
+    {
+        processSpectral(buffer, numChannels, time * delayMaxSamples, feedback, mix, gain);
+        return;
+    }
+
+    updateFeedbackChain(numChannels, 1);
+
+    // Oversampled saturation in the loop. Its filters delay the repeats, and
+    // the loop reads that much sooner to make up for it, so the echoes land
+    // on time with no latency to report. Only a delay shorter than the
+    // filters can't be shortened enough; then the dry signal waits instead.
+    int latency = saturator.getLatencyInSamples();
+    int dryDelay = currentTimeInSamples - latency < 1 ? latency : 0;
+
+    if (dryDelay != dryDelaySamples)
+    {
+        dryDelaySamples = dryDelay;
+        latencyBuffer.clear();
+        latencyPosition = 0;
+    }
+
+    if (dryDelay > 0)
+        delayDryInput(buffer, numChannels, dryDelay);
+
+    if (freezeHeld)
+    {
+        processFreeze(buffer, numChannels, static_cast<int>(time * delayMaxSamples), mix, gain);
+        return;
+    }
+
+    prepareLoopInput(buffer, numChannels);
+
+    bool tapeMode = mode == DelayMode::tape;
+
+    bool tapeHissActive = false;
+
+    if (tapeMode)
+    {
+        updateTapeTrajectory(juce::jlimit(minTapeDelay, (float) (delayMaxSamples - minTapeDelay), time * delayMaxSamples), buffer.getNumSamples());
+
+        // Wow and flutter wobble the read head on top of the glide, and hiss
+        // joins what it reads, so every pass round the loop adds some more
+        tapeWobble.setParameters(state.getRawParameterValue("wow")->load(),
+                                 state.getRawParameterValue("flutter")->load(),
+                                 state.getRawParameterValue("tapeHiss")->load());
+
+        if (tapeWobble.isModulating())
+            tapeWobble.modulate(delaySizeBuffer.data(), readSpeedBuffer.data(), buffer.getNumSamples());
+
+        tapeHissActive = tapeWobble.isHissing();
+
+        if (tapeHissActive)
+            tapeWobble.generateHiss(numChannels, buffer.getNumSamples());
+    }
+    else
+    {
+        tapeDelayInSamples = (float) currentTimeInSamples;
+
+        // Back in tape mode, the wobble starts from rest rather than from
+        // wherever it was left
+        tapeWobble.reset();
+    }
+
+    // The synced delay's glide across this block. The digital loop reads along
+    // it, and reverse and granular take their chunk and grain delays from it.
+    // Tape needs none, because its own glide already smooths the change.
+    bool syncRamping = syncActive && ! midiTimeActive && ! tapeMode;
+
+    if (syncRamping)
+    {
+        float step = (syncDelayInSamples - syncRampStart) / buffer.getNumSamples();
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            delaySizeBuffer[(size_t) i] = juce::jlimit(3.0f, (float) (delayMaxSamples - 3), syncRampStart + step * (i + 1) - latency);
+    }
+
+    if (mode == DelayMode::reverse)
+    {
+        processReverse(buffer, numChannels, juce::jlimit(8, delayMaxSamples / 2, static_cast<int>(time * delayMaxSamples) - latency),
+                       syncRamping ? delaySizeBuffer.data() : nullptr, feedback, mix, gain);
+        return;
+    }
+
+    reverseHeadsValid = false;
+
+    if (mode == DelayMode::granular)
+    {
+        processGranular(buffer, numChannels, static_cast<int>(time * delayMaxSamples) - latency,
+                        syncRamping ? delaySizeBuffer.data() : nullptr, feedback, mix, gain);
+        return;
+    }
+
+    if (grains.getNumActive() > 0)
+    {
+        grains.reset();
+        activeGrainCount = 0;
+    }
+
+    if (mode == DelayMode::crossfade)
+    {
+        processCrossfade(buffer, numChannels, juce::jlimit(1, delayMaxSamples - 1, static_cast<int>(time * delayMaxSamples) - latency), feedback, mix, gain);
+        return;
+    }
+
+    crossfadeDelay = juce::jmax(1, currentTimeInSamples);
+    crossfadePosition = -1;
+
+    // The delay line runs frame by frame, so that everything in the feedback
+    // path sees all the channels of a sample at once
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    int writeIndex = writeHeadBuffer[0];
+    int loopDelay = juce::jlimit(1, delayMaxSamples - 3, currentTimeInSamples - latency);
+
+    // Chorus / flanger / vibrato: an LFO swings the read head behind loopDelay
+    float modulationDepth = state.getRawParameterValue("modDepth")->load() * 0.001f * globalSampleRate;
+    bool modulationActive = ! tapeMode && modulationDepth > 0.0f;
+    bool modulationBatched = false;
+
+    if (modulationActive)
+    {
+        auto shape = static_cast<ModulationLFO::Shape>(static_cast<juce::AudioParameterChoice*>(state.getParameter("modShape"))->getIndex());
+
+        for (auto& lfo : lfos)
+        {
+            lfo.setShape(shape);
+            lfo.setFrequency(state.getRawParameterValue("modRate")->load());
+        }
+
+        loopDelay = juce::jmax(3, loopDelay);
+    }
+
+    // The sinc kernel reaches sincTaps - getTapsBefore() samples past the read
+    // index, and all of them have to be written history. Delays shorter than
+    // that read through the cubic instead.
+    if (useSincInterpolation)
+    {
+        float shortestDelay = syncRamping ? juce::jmin(delaySizeBuffer[0], delaySizeBuffer[(size_t) buffer.getNumSamples() - 1])
+                                          : (float) loopDelay;
+
+        if (shortestDelay < (float) (sincTaps - sincTable->getTapsBefore()))
+            useSincInterpolation = false;
+    }
+
+    if (modulationActive)
+        modulationBatched = prepareModulatedReads(numChannels, loopDelay, syncRamping ? delaySizeBuffer.data() : nullptr,
+                                                  modulationDepth, writeIndex, buffer.getNumSamples());
+
+    float frame[FeedbackFilter::maxChannels] = {};
+
+    // Iterate over each sample in the buffer
+    for (int i = 0; i < buffer.getNumSamples(); ++i)
+    {
+        if (tapeMode)
+        {
+            float readPosition = writeIndex - juce::jlimit(minTapeDelay, delayMaxSamples - minTapeDelay, delaySizeBuffer[i] - latency);
+
+            if (readPosition < 0.0f)
+                readPosition += delayMaxSamples;
+
+            int readIndex = static_cast<int>(readPosition);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                frame[channel] = readTapeSample(channel, readIndex, readPosition - readIndex, readSpeedBuffer[i]);
+
+            if (tapeHissActive)
+            {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    frame[channel] += tapeWobble.getHiss(channel)[i];
+            }
+        }
+        else if (modulationActive)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                if (modulationBatched)
+                {
+                    frame[channel] = modulatedReads.getSample(channel, i);
+                }
+                else
+                {
+                    float readPosition = modulationBuffer.getSample(channel, i);
+                    float readIndex = std::floor(readPosition);
+                    frame[channel] = interpolateSample(channel, readIndex, readPosition - readIndex);
+                }
+            }
+        }
+        else if (syncRamping)
+        {
+            float readPosition = writeIndex - delaySizeBuffer[(size_t) i];
+
+            if (readPosition < 0.0f)
+                readPosition += delayMaxSamples;
+
+            float readIndex = std::floor(readPosition);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                frame[channel] = interpolateSample(channel, readIndex, readPosition - readIndex);
+        }
+        else
+        {
+            // Get the read index based on the current time
+            int readIndex = (writeIndex - loopDelay + delayMaxSamples) % delayMaxSamples;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                frame[channel] = delayBuffer.getSample(channel, readIndex); // Get the delay sample
+        }
+
+        processLoopFrame(channels, i, numChannels, writeIndex, frame, feedback, mix, gain);
+
+        // Update write index
+        writeIndex = (writeIndex + 1) % delayMaxSamples;
+    }
+
+    // Update write head buffer
+    for (auto& writeHead : writeHeadBuffer)
+        writeHead = writeIndex;
+
+    refreshGuardZone();
 }
 
 //==============================================================================
@@ -9,6 +9,23 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AllpassDiffuser.h"
+#include "BucketBrigade.h"
+#include "CombResonator.h"
+#include "EnvelopeFollower.h"
+#include "FdnReverb.h"
+#include "FeedbackFilter.h"
+#include "FeedbackMatrix.h"
+#include "FeedbackSaturator.h"
+#include "GrainPool.h"
+#include "ModulationLFO.h"
+#include "MultiTapDelay.h"
+#include "PitchShifter.h"
+#include "RateReducer.h"
+#include "SpectralDelay.h"
+#include "TapeWobble.h"
+#include "VarispeedInterpolator.h"
+#include "WindowedSincTable.h"
 
 //==============================================================================
 /**
@@ -53,20 +70,100 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    enum class DelayMode
+    {
+        digital = 0,
+        tape,
+        crossfade,
+        reverb,
+        reverse,
+        granular,
+        spectral,
+        multiTap,
+        resonator,
+        lofi,
+        bbd
+    };
+
+    /** How many grains granular mode is playing, for monitoring. Safe to call
+        from any thread.
+    */
+    int getActiveGrainCount() const noexcept     { return activeGrainCount.load(); }
+
     juce::AudioProcessorValueTreeState state;
     void resampleBuffer (int initialSampleSize, int targetSampleSize);
+    void advanceResample (int maxSamples);
     float calculateReadIndex(float time);
     float calculateInterpolationFactor(float previousTime, float currentTime);
     float interpolateSample(int channel, float readIndex, float mu);
+    void interpolateSamples (int channel, const float* readPositions, float* destination, int numSamples) const;
     float sampleRateInterpolation(int channel, float previousTime, float currentTime);
+    void convertHistoryToSampleRate (double newSampleRate, int newMaxSamples);
+    void updateTapeTrajectory (float targetDelay, int numSamples);
+    float readTapeSample (int channel, int readIndex, float fraction, float speed);
+    void readDelaySpan (int channel, int writeIndex, int delayInSamples, float* destination, int numSamples) const;
+    void writeDelaySpan (int channel, int writeIndex, const float* source, int numSamples);
+    bool prepareModulatedReads (int numChannels, int baseDelay, const float* delays, float depth, int writeIndex, int numSamples);
+    void updateTempoSync();
+    void processSection (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    void processMidiSection (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int startSample, int endSample);
+    void handleMidiClock (juce::int64 samplePosition);
+    void clearDelayLines();
+    void delayDryInput (juce::AudioBuffer<float>& buffer, int numChannels, int latency);
+    void updateFeedbackChain (int numChannels, int rateFactor);
+    void prepareLoopInput (juce::AudioBuffer<float>& buffer, int numChannels);
+    void processFeedbackChain (float* frame, float* feedbackFrame, int numChannels);
+    void processLoopFrame (float* const* channels, int sampleIndex, int numChannels, int writeIndex,
+                           float* frame, float feedback, float mix, float gain);
+    void processLoopBlock (float* const* channels, int startSample, int numChannels, int writeIndex,
+                           float* const* wet, int numSamples, float feedback, float mix, float gain);
+    void processCrossfade (juce::AudioBuffer<float>& buffer, int numChannels, int targetDelay, float feedback, float mix, float gain);
+    void readReverseSpan (int channel, int fromIndex, float* destination, int numSamples) const;
+    void processReverse (juce::AudioBuffer<float>& buffer, int numChannels, int chunkLength, const float* chunkLengths, float feedback, float mix, float gain);
+    void updateDucking (juce::AudioBuffer<float>& buffer, int numChannels, float amount);
+    void processFreeze (juce::AudioBuffer<float>& buffer, int numChannels, int loopLength, float mix, float gain);
+    void recordEngineOutput (int numChannels, int numSamples);
+    void mixEngineOutput (juce::AudioBuffer<float>& buffer, float* const* wet, int numChannels, float mix, float gain);
+    void processGranular (juce::AudioBuffer<float>& buffer, int numChannels, int delayInSamples, const float* delays, float feedback, float mix, float gain);
+    void processSpectral (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain);
+    void processMultiTap (juce::AudioBuffer<float>& buffer, int numChannels, float patternLength, float mix, float gain);
+    void processResonator (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages, int numChannels, float mix, float gain);
+    void processReverb (juce::AudioBuffer<float>& buffer, int numChannels, float mix, float gain);
+    void processBbd (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain);
+    void processLofi (juce::AudioBuffer<float>& buffer, int numChannels, float delayInSamples, float feedback, float mix, float gain, bool frozen);
 private:
     //==============================================================================
     int delayWritePosition = 0;
     juce::AudioBuffer<float> delayBuffer;
     float globalSampleRate = 44100;
+    double preparedSampleRate = 0.0;
     int oldTimeInSamples = 44100;
     juce::LinearSmoothedValue<float> timeSmoothed { 0.3f };
-    int delayMaxSamples;
+
+    // Tempo sync. The delay is only worked out again when the host tempo or
+    // the note value changes; syncRampedDelay is where the per-sample glide
+    // got to at the end of the last block, or -1 to jump straight there
+    double hostBpm = 120.0;
+    double syncBpm = 0.0;
+    int syncDivision = -1;
+    int syncModifier = -1;
+    float syncDelayInSamples = 0.0f;
+    float syncRampedDelay = -1.0f;
+
+    // MIDI control. Note-ons tune the delay time to the note, two notes hold
+    // freeze and clear the delay, and a running clock sets the sync tempo.
+    // The section buffers carry the events of a piece of the host block with
+    // their positions made relative to it, and are sized up front.
+    static constexpr int midiFreezeNote = 36;
+    static constexpr int midiClearNote = 38;
+    juce::MidiBuffer midiBlockSection, midiEventSection;
+    juce::int64 midiSampleCounter = 0;
+    juce::int64 lastClockSample = -1;
+    double clockInterval = 0.0;
+    double midiClockBpm = 0.0;
+    float midiDelayInSamples = -1.0f;
+    bool midiFreezeHeld = false;
+    int delayMaxSamples = 0;
     int delayRead = 0;
     int delayWrite = 0;
     std::vector<int> writeHeadBuffer;
@@ -74,8 +171,133 @@ private:
     int lastWriteHead = 0;
     int lastReadHead = 0;
     int currentTimeInSamples = 44100;
-    std::vector<int> delaySizeBuffer;
+    std::vector<float> delaySizeBuffer;
+    std::vector<float> readSpeedBuffer;
     int maxDelay = 2;
+    int preparedBlockSize = 0;
+
+    // delayBuffer holds guardSamples extra samples past delayMaxSamples that mirror
+    // the start of the ring, so cubic reads never have to wrap mid-kernel
+    static constexpr int guardSamples = 3;
+    void refreshGuardZone();
+
+    // Tape re-time job, advanced by at most retimeSamplesPerBlock samples per callback
+    static constexpr int retimeSamplesPerBlock = 4096;
+    bool retimeActive = false;
+    DelayMode retimeMode = DelayMode::digital;
+    int retimeSourceSize = 0;
+    int retimeTargetSize = 0;
+    int retimeProgress = 0;
+    std::array<int, 2> retimeEnd {};
+
+    // Each re-timed sample waits here for retimePendingSize steps before it's
+    // written, by which time no interpolation kernel still needs what it replaces
+    static constexpr int retimePendingSize = 32;
+    std::array<std::array<float, retimePendingSize>, 2> retimePending {};
+
+    // High-quality fractional reads, used by interpolateSample
+    static constexpr int sincTaps = 32;
+    static constexpr int sincPhases = 512;
+    std::shared_ptr<const WindowedSincTable> sincTable;
+    bool useSincInterpolation = false;
+
+    // Tape mode read head
+    static constexpr float tapeGlideSeconds = 0.2f;
+    static constexpr float minTapeDelay = (float) (VarispeedInterpolator::numTaps / 2 + 2);
+    float tapeGlideCoefficient = 0.0f;
+    float tapeDelayInSamples = 0.0f;
+    juce::SharedResourcePointer<VarispeedInterpolator> varispeedInterpolator;
+
+    // Crossfade mode read heads
+    static constexpr double crossfadeSeconds = 0.03;
+    int crossfadeDelay = 1;
+    int crossfadeTargetDelay = 1;
+    int crossfadePosition = -1;
+    std::vector<float> crossfadeTable;
+    std::vector<float> crossfadeGainBuffer;
+    juce::AudioBuffer<float> crossfadeHeads;
+
+    // Reverse mode read heads, each playing one chunk backwards
+    struct ReverseHead
+    {
+        int start = 0;
+        int position = 0;
+        int length = 1;
+    };
+
+    static constexpr int reverseWindowSize = 2048;
+    std::vector<float> reverseWindow;
+    std::array<ReverseHead, 2> reverseHeads;
+    bool reverseHeadsValid = false;
+
+    // Ducking of the wet signal, with one gain per sample of the block
+    EnvelopeFollower duckFollower;
+    std::vector<float> duckGainBuffer;
+    bool duckingActive = false;
+
+    // Frozen loop, as a span of the delay line that is no longer written
+    bool freezeActive = false;
+    int freezeStart = 0;
+    int freezeLength = 1;
+    int freezePosition = 0;
+
+    // Granular mode
+    GrainPool grains;
+    juce::Random grainRandom;
+    float grainCountdown = 0.0f;
+    std::atomic<int> activeGrainCount { 0 };
+
+    FeedbackFilter feedbackFilter;
+    bool filterActive = false;
+
+    FeedbackMatrix feedbackMatrix;
+    bool matrixActive = false;
+
+    // Shimmer: the octave shifter on what feeds back
+    PitchShifter shimmer;
+    int shimmerSetting = 0;
+    bool shimmerActive = false;
+
+    // Saturation, and the dry delay for times too short for the loop to make
+    // up its latency
+    static constexpr int maxLatencySamples = 32;
+    FeedbackSaturator saturator;
+    bool saturatorActive = false;
+    juce::AudioBuffer<float> latencyBuffer;
+    int latencyPosition = 0;
+    int dryDelaySamples = 0;
+
+    FdnReverb reverb;
+    std::array<SpectralDelay, 2> spectralDelays;
+    MultiTapDelay multiTap;
+
+    // Wow, flutter and hiss on the tape mode read head
+    TapeWobble tapeWobble;
+    BucketBrigade bucketBrigade;
+
+    // Lo-fi mode runs the delay line at a half or a quarter of the host rate,
+    // in the first lofiRingLength samples of delayBuffer; 0 when it isn't running
+    RateReducer rateReducer;
+    int lofiRingLength = 0;
+    int lofiWritePosition = 0;
+
+    // Resonator mode, tuned by the last MIDI note or the note parameter
+    CombResonator resonator;
+    int resonatorNote = 57;
+    int lastResonatorParameterNote = -1;
+
+    // Allpass diffusion, and what the loop writes as its input: the host
+    // buffer, or the diffused copy of it
+    AllpassDiffuser diffuser;
+    int diffusionPlacement = 0;
+    bool diffusionInLoop = false;
+    juce::AudioBuffer<float> diffusedInput;
+    const float* loopInput[FeedbackMatrix::maxChannels] {};
+
+    // Read position modulation
+    std::array<ModulationLFO, 2> lfos;
+    juce::AudioBuffer<float> modulationBuffer;
+    juce::AudioBuffer<float> modulatedReads;
     
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TutorialADCAudioProcessor)
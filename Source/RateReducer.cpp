@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    RateReducer.cpp
+    Half-band decimation and interpolation around a reduced-rate delay core.
+
+  ==============================================================================
+*/
+
+#include "RateReducer.h"
+
+//==============================================================================
+void RateReducer::reset()
+{
+    firstDown.reset();
+    secondDown.reset();
+    firstUp.reset();
+    secondUp.reset();
+
+    pending.fill (Float4::broadcast (0.0f));
+    queue.fill (Float4::broadcast (0.0f));
+    pendingCount = 0;
+    queuePosition = 0;
+}
+
+void RateReducer::setFactor (Factor newFactor) noexcept
+{
+    auto newValue = newFactor == Factor::quarter ? 4 : 2;
+
+    if (newValue != factor)
+    {
+        factor = newValue;
+        reset();
+    }
+}
+
+int RateReducer::getLatencyInSamples() const noexcept
+{
+    // Each up/down pair delays by 2 * (2 * halfTaps - 1) samples at its higher
+    // rate, which for the inner pair at a quarter rate is twice that in host
+    // samples. Waiting for a whole group adds factor - 1 more.
+    constexpr int pairLatency = 2 * (2 * Halfband::halfTaps - 1);
+
+    return factor == 4 ? 3 * pairLatency + 3 : pairLatency + 1;
+}
+
+bool RateReducer::push (Float4 input, Float4& reduced) noexcept
+{
+    pending[(size_t) pendingCount++] = input;
+
+    if (pendingCount < factor)
+        return false;
+
+    pendingCount = 0;
+
+    if (factor == 4)
+    {
+        auto first = firstDown.process (pending[0], pending[1]);
+        auto second = firstDown.process (pending[2], pending[3]);
+        reduced = secondDown.process (first, second);
+    }
+    else
+    {
+        reduced = firstDown.process (pending[0], pending[1]);
+    }
+
+    return true;
+}
+
+void RateReducer::interpolate (Float4 output) noexcept
+{
+    if (factor == 4)
+    {
+        Float4 first, second;
+        secondUp.process (output, first, second);
+        firstUp.process (first, queue[0], queue[1]);
+        firstUp.process (second, queue[2], queue[3]);
+    }
+    else
+    {
+        firstUp.process (output, queue[0], queue[1]);
+    }
+
+    queuePosition = 0;
+}
+
+Float4 RateReducer::pull() noexcept
+{
+    // Frames from before the first group are silence
+    return queuePosition < factor ? queue[(size_t) queuePosition++] : Float4::broadcast (0.0f);
+}
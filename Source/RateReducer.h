@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    RateReducer.h
+    Half-band decimation and interpolation around a reduced-rate delay core.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HalfbandFilter.h"
+
+//==============================================================================
+/**
+    Takes host-rate frames down to a half or a quarter of the rate through one
+    or two half-band stages, and brings what the core makes of them back up
+    through the same stages.
+
+    For every host-rate frame, push() it, and when it returns true, run the
+    core on the reduced frame and hand the result to interpolate(). Then pull()
+    the host-rate output for that frame. Every SIMD lane carries one channel.
+*/
+class RateReducer
+{
+public:
+    static constexpr int maxChannels = 4;
+
+    enum class Factor
+    {
+        half = 0,
+        quarter
+    };
+
+    void reset();
+    void setFactor (Factor newFactor) noexcept;
+
+    /** How many host-rate samples make one reduced-rate sample: 2 or 4. */
+    int getFactor() const noexcept       { return factor; }
+
+    /** The delay the filters and the grouping add to a signal that goes down
+        and straight back up, in host-rate samples.
+    */
+    int getLatencyInSamples() const noexcept;
+
+    /** Takes one host-rate frame. Returns true, with the reduced-rate frame in
+        reduced, once every factor frames.
+    */
+    bool push (Float4 input, Float4& reduced) noexcept;
+
+    /** Takes the core's reduced-rate output and queues its host-rate frames. */
+    void interpolate (Float4 output) noexcept;
+
+    /** The next host-rate output frame. */
+    Float4 pull() noexcept;
+
+private:
+    Halfband::Downsampler firstDown, secondDown;
+    Halfband::Upsampler firstUp, secondUp;
+
+    std::array<Float4, 4> pending {}, queue {};
+    int factor = 2;
+    int pendingCount = 0, queuePosition = 0;
+};
@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    SIMDVector.h
+    A four-lane float vector that maps onto SSE or NEON registers, with a plain
+    scalar fallback for anything else.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #define TUTORIALADC_SIMD_SSE 1
+#elif JUCE_ARM && (defined (__aarch64__) || defined (_M_ARM64))
+ #include <arm_neon.h>
+ #define TUTORIALADC_SIMD_NEON 1
+#endif
+
+//==============================================================================
+/**
+    Four floats processed together. Loads and stores are unaligned, so it can be
+    pointed straight at any position inside a delay line.
+*/
+struct Float4
+{
+   #if TUTORIALADC_SIMD_SSE
+    __m128 value;
+   #elif TUTORIALADC_SIMD_NEON
+    float32x4_t value;
+   #else
+    float value[4];
+   #endif
+
+    static Float4 load (const float* source) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_loadu_ps (source) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vld1q_f32 (source) };
+       #else
+        return { { source[0], source[1], source[2], source[3] } };
+       #endif
+    }
+
+    static Float4 broadcast (float x) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_set1_ps (x) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vdupq_n_f32 (x) };
+       #else
+        return { { x, x, x, x } };
+       #endif
+    }
+
+    void store (float* destination) const noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        _mm_storeu_ps (destination, value);
+       #elif TUTORIALADC_SIMD_NEON
+        vst1q_f32 (destination, value);
+       #else
+        for (int i = 0; i < 4; ++i)
+            destination[i] = value[i];
+       #endif
+    }
+
+    friend Float4 operator+ (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_add_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vaddq_f32 (a.value, b.value) };
+       #else
+        return { { a.value[0] + b.value[0], a.value[1] + b.value[1], a.value[2] + b.value[2], a.value[3] + b.value[3] } };
+       #endif
+    }
+
+    friend Float4 operator- (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_sub_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vsubq_f32 (a.value, b.value) };
+       #else
+        return { { a.value[0] - b.value[0], a.value[1] - b.value[1], a.value[2] - b.value[2], a.value[3] - b.value[3] } };
+       #endif
+    }
+
+    friend Float4 operator* (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_mul_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vmulq_f32 (a.value, b.value) };
+       #else
+        return { { a.value[0] * b.value[0], a.value[1] * b.value[1], a.value[2] * b.value[2], a.value[3] * b.value[3] } };
+       #endif
+    }
+
+    friend Float4 operator/ (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_div_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vdivq_f32 (a.value, b.value) };
+       #else
+        return { { a.value[0] / b.value[0], a.value[1] / b.value[1], a.value[2] / b.value[2], a.value[3] / b.value[3] } };
+       #endif
+    }
+
+    static Float4 min (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_min_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vminq_f32 (a.value, b.value) };
+       #else
+        return { { std::min (a.value[0], b.value[0]), std::min (a.value[1], b.value[1]), std::min (a.value[2], b.value[2]), std::min (a.value[3], b.value[3]) } };
+       #endif
+    }
+
+    static Float4 max (Float4 a, Float4 b) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_max_ps (a.value, b.value) };
+       #elif TUTORIALADC_SIMD_NEON
+        return { vmaxq_f32 (a.value, b.value) };
+       #else
+        return { { std::max (a.value[0], b.value[0]), std::max (a.value[1], b.value[1]), std::max (a.value[2], b.value[2]), std::max (a.value[3], b.value[3]) } };
+       #endif
+    }
+
+    /** Returns a + b * c. */
+    static Float4 multiplyAdd (Float4 a, Float4 b, Float4 c) noexcept
+    {
+       #if TUTORIALADC_SIMD_NEON
+        return { vmlaq_f32 (a.value, b.value, c.value) };
+       #else
+        return a + b * c;
+       #endif
+    }
+
+    /** Transposes four vectors as if they were the rows of a 4x4 matrix. */
+    static void transpose (Float4& a, Float4& b, Float4& c, Float4& d) noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        _MM_TRANSPOSE4_PS (a.value, b.value, c.value, d.value);
+       #elif TUTORIALADC_SIMD_NEON
+        auto ab = vtrnq_f32 (a.value, b.value);
+        auto cd = vtrnq_f32 (c.value, d.value);
+        a.value = vcombine_f32 (vget_low_f32 (ab.val[0]),  vget_low_f32 (cd.val[0]));
+        b.value = vcombine_f32 (vget_low_f32 (ab.val[1]),  vget_low_f32 (cd.val[1]));
+        c.value = vcombine_f32 (vget_high_f32 (ab.val[0]), vget_high_f32 (cd.val[0]));
+        d.value = vcombine_f32 (vget_high_f32 (ab.val[1]), vget_high_f32 (cd.val[1]));
+       #else
+        std::swap (a.value[1], b.value[0]);
+        std::swap (a.value[2], c.value[0]);
+        std::swap (a.value[3], d.value[0]);
+        std::swap (b.value[2], c.value[1]);
+        std::swap (b.value[3], d.value[1]);
+        std::swap (c.value[3], d.value[2]);
+       #endif
+    }
+
+    /** Returns the lanes in the opposite order. */
+    Float4 reversed() const noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        return { _mm_shuffle_ps (value, value, _MM_SHUFFLE (0, 1, 2, 3)) };
+       #elif TUTORIALADC_SIMD_NEON
+        auto pairsSwapped = vrev64q_f32 (value);
+        return { vcombine_f32 (vget_high_f32 (pairsSwapped), vget_low_f32 (pairsSwapped)) };
+       #else
+        return { { value[3], value[2], value[1], value[0] } };
+       #endif
+    }
+
+    /** Adds the four lanes together. */
+    float sum() const noexcept
+    {
+       #if TUTORIALADC_SIMD_SSE
+        auto pairs = _mm_add_ps (value, _mm_movehl_ps (value, value));
+        return _mm_cvtss_f32 (_mm_add_ss (pairs, _mm_shuffle_ps (pairs, pairs, 1)));
+       #elif TUTORIALADC_SIMD_NEON
+        auto pairs = vadd_f32 (vget_low_f32 (value), vget_high_f32 (value));
+        return vget_lane_f32 (vpadd_f32 (pairs, pairs), 0);
+       #else
+        return (value[0] + value[1]) + (value[2] + value[3]);
+       #endif
+    }
+};
+
+//==============================================================================
+/** Dot product of two arrays whose length is a multiple of four. */
+inline float dotProduct (const float* a, const float* b, int length) noexcept
+{
+    auto total = Float4::broadcast (0.0f);
+
+    for (int i = 0; i < length; i += 4)
+        total = Float4::multiplyAdd (total, Float4::load (a + i), Float4::load (b + i));
+
+    return total.sum();
+}
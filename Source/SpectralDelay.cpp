@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    SpectralDelay.cpp
+    STFT delay where every frequency band has its own delay time and feedback.
+
+  ==============================================================================
+*/
+
+#include "SpectralDelay.h"
+
+//==============================================================================
+SpectralDelay::SpectralDelay()
+{
+    // Periodic Hann for analysis and synthesis. At a quarter-frame hop the
+    // squared windows add up to 1.5, which the synthesis window divides out.
+    window.resize ((size_t) fftSize);
+
+    for (int i = 0; i < fftSize; ++i)
+        window[(size_t) i] = 0.5f - 0.5f * std::cos (juce::MathConstants<float>::twoPi * (float) i / (float) fftSize);
+
+    inputRing.assign ((size_t) fftSize, 0.0f);
+    outputRing.assign ((size_t) outputSize, 0.0f);
+    frame.assign ((size_t) (2 * fftSize), 0.0f);
+    binDelays.assign ((size_t) numBins, 0);
+    binFeedback.assign ((size_t) numBins, 0.0f);
+}
+
+void SpectralDelay::prepare (double newSampleRate, double maxDelaySeconds)
+{
+    auto newHistoryFrames = (int) std::ceil (maxDelaySeconds * newSampleRate / hopSize) + 1;
+
+    // Same rate and length: keep what's in the history
+    if (newSampleRate == sampleRate && newHistoryFrames == historyFrames && ! history.empty())
+        return;
+
+    sampleRate = newSampleRate;
+    historyFrames = newHistoryFrames;
+    history.assign ((size_t) (numBins * historyFrames), {});
+
+    // Bands split the spectrum evenly on a log scale from 50 Hz up
+    for (int band = 0; band < numBands; ++band)
+    {
+        auto edge = band == 0 ? 0.0 : 50.0 * std::pow (sampleRate * 0.5 / 50.0, (double) band / numBands);
+        bandFirstBins[(size_t) band] = juce::jlimit (0, numBins, (int) std::ceil (edge * fftSize / sampleRate));
+    }
+
+    bandDelays.fill (-1.0f);
+    bandFeedback.fill (-1.0f);
+    reset();
+}
+
+void SpectralDelay::reset()
+{
+    std::fill (inputRing.begin(), inputRing.end(), 0.0f);
+    std::fill (outputRing.begin(), outputRing.end(), 0.0f);
+    std::fill (history.begin(), history.end(), std::complex<float>());
+    inputPosition = outputPosition = hopPosition = historyPosition = 0;
+    unitsDone = workUnits;
+}
+
+void SpectralDelay::setBand (int band, float delayInSamples, float feedback)
+{
+    if (band < 0 || band >= numBands
+        || (delayInSamples == bandDelays[(size_t) band] && feedback == bandFeedback[(size_t) band]))
+        return;
+
+    bandDelays[(size_t) band] = delayInSamples;
+    bandFeedback[(size_t) band] = feedback;
+
+    auto frames = juce::jlimit (0, historyFrames - 1, juce::roundToInt (delayInSamples / hopSize));
+    auto lastBin = band + 1 < numBands ? bandFirstBins[(size_t) band + 1] : numBins;
+
+    for (int bin = bandFirstBins[(size_t) band]; bin < lastBin; ++bin)
+    {
+        binDelays[(size_t) bin] = frames;
+        binFeedback[(size_t) bin] = juce::jlimit (0.0f, 1.0f, feedback);
+    }
+}
+
+void SpectralDelay::startFrame() noexcept
+{
+    // Whatever is left of the last frame has to be finished first
+    doWork (workUnits);
+
+    // The newest fftSize input samples, oldest first
+    auto firstPart = fftSize - inputPosition;
+    std::copy (inputRing.begin() + inputPosition, inputRing.end(), frame.begin());
+    std::copy (inputRing.begin(), inputRing.begin() + inputPosition, frame.begin() + firstPart);
+
+    // The result is added in starting one hop from now, which is when the
+    // work for it is guaranteed to be done
+    frameOutputStart = (outputPosition + hopSize) % outputSize;
+    historyPosition = (historyPosition + 1) % historyFrames;
+    unitsDone = 0;
+}
+
+void SpectralDelay::processBins (int firstBin, int lastBin) noexcept
+{
+    auto* spectrum = reinterpret_cast<std::complex<float>*> (frame.data());
+
+    for (int bin = firstBin; bin < lastBin; ++bin)
+    {
+        auto* binHistory = history.data() + bin * historyFrames;
+        auto readPosition = historyPosition - binDelays[(size_t) bin];
+
+        if (readPosition < 0)
+            readPosition += historyFrames;
+
+        // A zero delay reads the input straight through and feeds nothing back
+        auto input = spectrum[bin];
+        auto delayed = binDelays[(size_t) bin] == 0 ? input : binHistory[readPosition];
+
+        binHistory[historyPosition] = input + delayed * binFeedback[(size_t) bin];
+        spectrum[bin] = delayed;
+    }
+}
+
+void SpectralDelay::doWork (int targetUnits) noexcept
+{
+    for (; unitsDone < targetUnits; ++unitsDone)
+    {
+        if (unitsDone == 0)
+        {
+            juce::FloatVectorOperations::multiply (frame.data(), window.data(), fftSize);
+            fft.performRealOnlyForwardTransform (frame.data(), true);
+        }
+        else if (unitsDone <= numBinChunks)
+        {
+            auto firstBin = (unitsDone - 1) * binsPerChunk;
+            processBins (firstBin, juce::jmin (numBins, firstBin + binsPerChunk));
+        }
+        else
+        {
+            fft.performRealOnlyInverseTransform (frame.data());
+
+            // Synthesis window, with the 1.5 overlap gain taken out
+            juce::FloatVectorOperations::multiply (frame.data(), window.data(), fftSize);
+            juce::FloatVectorOperations::multiply (frame.data(), 1.0f / 1.5f, fftSize);
+
+            auto firstPart = juce::jmin (fftSize, outputSize - frameOutputStart);
+            juce::FloatVectorOperations::add (outputRing.data() + frameOutputStart, frame.data(), firstPart);
+            juce::FloatVectorOperations::add (outputRing.data(), frame.data() + firstPart, fftSize - firstPart);
+        }
+    }
+}
+
+void SpectralDelay::process (const float* input, float* output, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples;)
+    {
+        // Up to the next frame, or the end of a ring, whichever comes first
+        auto run = juce::jmin (numSamples - i, hopSize - hopPosition,
+                               juce::jmin (fftSize - inputPosition, outputSize - outputPosition));
+
+        std::copy (input + i, input + i + run, inputRing.begin() + inputPosition);
+        std::copy (outputRing.begin() + outputPosition, outputRing.begin() + outputPosition + run, output + i);
+        std::fill (outputRing.begin() + outputPosition, outputRing.begin() + outputPosition + run, 0.0f);
+
+        inputPosition = (inputPosition + run) % fftSize;
+        outputPosition = (outputPosition + run) % outputSize;
+        hopPosition += run;
+        i += run;
+
+        if (hopPosition == hopSize)
+        {
+            hopPosition = 0;
+            startFrame();
+        }
+        else
+        {
+            // Keep the frame's work in step with how far into the hop we are
+            doWork (workUnits * hopPosition / hopSize);
+        }
+    }
+}
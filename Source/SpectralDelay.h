@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    SpectralDelay.h
+    STFT delay where every frequency band has its own delay time and feedback.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Delays one channel in the frequency domain. Each hop, a Hann-windowed frame
+    is transformed and every bin is delayed by a whole number of frames, with
+    its own feedback, through a ring of past spectra. The ring keeps each bin's
+    history together, so a bin's reads and writes stay in one small region.
+
+    The work for a frame (forward FFT, the bins in a few chunks, inverse FFT)
+    is spread over the following hop, in step with the samples processed. That
+    keeps the cost per callback flat whatever the host block size. It costs an
+    extra hop of delay, which getLatencyInSamples() includes.
+*/
+class SpectralDelay
+{
+public:
+    static constexpr int fftOrder = 10;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int numBins = fftSize / 2 + 1;
+    static constexpr int numBands = 8;
+
+    SpectralDelay();
+
+    /** Allocates a history long enough for maxDelaySeconds. */
+    void prepare (double sampleRate, double maxDelaySeconds);
+    void reset();
+
+    /** Sets the delay (in samples, on top of the latency) and feedback of one
+        band. Only the bins of that band are touched, and only on a change.
+    */
+    void setBand (int band, float delayInSamples, float feedback);
+
+    /** How far the wet signal lags when every band is set to zero delay. */
+    static constexpr int getLatencyInSamples() noexcept    { return fftSize + hopSize; }
+
+    /** Writes the wet signal for input into output. They may be the same buffer. */
+    void process (const float* input, float* output, int numSamples) noexcept;
+
+private:
+    void startFrame() noexcept;
+    void doWork (int targetUnits) noexcept;
+    void processBins (int firstBin, int lastBin) noexcept;
+
+    static constexpr int binsPerChunk = 128;
+    static constexpr int numBinChunks = (numBins + binsPerChunk - 1) / binsPerChunk;
+    static constexpr int workUnits = numBinChunks + 2;
+    static constexpr int outputSize = 2 * fftSize;
+
+    juce::dsp::FFT fft { fftOrder };
+    std::vector<float> window;
+    std::vector<float> inputRing, outputRing, frame;
+
+    // history[bin * historyFrames + frame]
+    std::vector<std::complex<float>> history;
+    int historyFrames = 1;
+    int historyPosition = 0;
+
+    std::vector<int> binDelays;
+    std::vector<float> binFeedback;
+    std::array<int, numBands> bandFirstBins {};
+    std::array<float, numBands> bandDelays {}, bandFeedback {};
+
+    int inputPosition = 0, outputPosition = 0;
+    int hopPosition = 0;
+    int unitsDone = workUnits;
+    int frameOutputStart = 0;
+    double sampleRate = 44100.0;
+};
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    TapeWobble.cpp
+    Wow, flutter and hiss for the tape read head.
+
+  ==============================================================================
+*/
+
+#include "TapeWobble.h"
+
+//==============================================================================
+namespace
+{
+    // Full-scale depths, in seconds of read-head movement. The sines alone
+    // swing the pitch by about 0.5% at the wow rate and 0.4% at the flutter rate
+    constexpr float maxWowSeconds = 0.0016f;
+    constexpr float maxFlutterSeconds = 0.0001f;
+
+    constexpr float wowHz = 0.55f, flutterHz = 6.5f;
+    constexpr float wowDriftHz = 1.0f, flutterDriftHz = 20.0f;
+
+    // Uniform noise peaking at 1 is about -55 dB RMS at full hiss
+    constexpr float maxHissGain = 0.003f;
+}
+
+void TapeWobble::Phasor::setFrequency (float hz, float rate)
+{
+    auto step = juce::MathConstants<float>::twoPi * hz / rate;
+    stepCos = std::cos (step);
+    stepSin = std::sin (step);
+}
+
+void TapeWobble::Phasor::normalise() noexcept
+{
+    auto correction = 1.5f - 0.5f * (cosine * cosine + sine * sine);
+    cosine *= correction;
+    sine *= correction;
+}
+
+void TapeWobble::SmoothedNoise::setCutoff (float hz, float rate)
+{
+    // Two poles rather than one, so the drift's slope, which is what the
+    // read speed follows, is smooth too
+    auto pole = std::exp (-juce::MathConstants<double>::twoPi * hz / rate);
+    coefficient = (float) (1.0 - pole);
+
+    // The pair passes (1 - p)^4 (1 + p^2) / (1 - p^2)^3 of white noise's
+    // power; make that back up so the drift swings about as far as the input
+    auto p2 = pole * pole;
+    auto power = std::pow (1.0 - pole, 4.0) * (1.0 + p2) / std::pow (1.0 - p2, 3.0);
+    gain = (float) std::sqrt (1.0 / power);
+}
+
+void TapeWobble::prepare (double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = (float) newSampleRate;
+    blockSize = maximumBlockSize;
+    noise.assign ((size_t) (2 * blockSize), 0.0f);
+    hiss.assign ((size_t) (maxChannels * blockSize), 0.0f);
+
+    wowCycle.setFrequency (wowHz, sampleRate);
+    flutterCycle.setFrequency (flutterHz, sampleRate);
+    wowDrift.setCutoff (wowDriftHz, sampleRate);
+    flutterDrift.setCutoff (flutterDriftHz, sampleRate);
+    reset();
+}
+
+void TapeWobble::reset()
+{
+    wowCycle.cosine = flutterCycle.cosine = 1.0f;
+    wowCycle.sine = flutterCycle.sine = 0.0f;
+    wowDrift.first = wowDrift.value = flutterDrift.first = flutterDrift.value = 0.0f;
+    previousOffset = 0.0f;
+}
+
+void TapeWobble::setParameters (float wow, float flutter, float hissAmount)
+{
+    bool wasModulating = isModulating();
+    wowDepth = juce::jlimit (0.0f, 1.0f, wow) * maxWowSeconds * sampleRate;
+    flutterDepth = juce::jlimit (0.0f, 1.0f, flutter) * maxFlutterSeconds * sampleRate;
+
+    // previousOffset still holds where the head was when the wobble stopped;
+    // carried over, it would jolt the read speed on the first sample
+    if (isModulating() && ! wasModulating)
+        reset();
+
+    // Squared, so the lower half of the range stays in the background
+    hissAmount = juce::jlimit (0.0f, 1.0f, hissAmount);
+    hissGain = hissAmount * hissAmount * maxHissGain;
+}
+
+void TapeWobble::modulate (float* delays, float* speeds, int numSamples) noexcept
+{
+    if (noise.empty())
+        return;
+
+    numSamples = juce::jmin (numSamples, blockSize);
+    random.fill (noise.data(), 2 * numSamples);
+    const auto* wowNoise = noise.data();
+    const auto* flutterNoise = noise.data() + numSamples;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto wow = 0.6f * wowCycle.advance() + 0.4f * wowDrift.process (wowNoise[i]);
+        auto flutter = 0.5f * flutterCycle.advance() + 0.5f * flutterDrift.process (flutterNoise[i]);
+        auto offset = wowDepth * wow + flutterDepth * flutter;
+
+        // A delay that grows by one sample per sample slows playback by as
+        // much, just like the tape trajectory's glide
+        delays[i] += offset;
+        speeds[i] -= offset - previousOffset;
+        previousOffset = offset;
+    }
+
+    wowCycle.normalise();
+    flutterCycle.normalise();
+}
+
+void TapeWobble::generateHiss (int numChannels, int numSamples) noexcept
+{
+    if (hiss.empty())
+        return;
+
+    numChannels = juce::jmin (numChannels, maxChannels);
+    numSamples = juce::jmin (numSamples, blockSize);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* destination = hiss.data() + (size_t) channel * (size_t) blockSize;
+        random.fill (destination, numSamples);
+        juce::FloatVectorOperations::multiply (destination, hissGain, numSamples);
+    }
+}
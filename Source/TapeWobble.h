@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    TapeWobble.h
+    Wow, flutter and hiss for the tape read head.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "NoiseGenerator.h"
+
+//==============================================================================
+/**
+    Speed wobble and hiss, the two things an old tape echo adds to every pass.
+
+    Wow is a slow sine mixed with noise smoothed to around a hertz; flutter
+    is a faster sine mixed with noise smoothed to a few tens of hertz. The
+    sines run as rotating phasors, the smoothing is two one-poles each, and
+    all the noise for a block comes from one NoiseGenerator fill.
+*/
+class TapeWobble
+{
+public:
+    static constexpr int maxChannels = 2;
+
+    void prepare (double sampleRate, int maximumBlockSize);
+    void reset();
+
+    /** Sets wow, flutter and hiss, each from 0 to 1. Turning wow or flutter
+        back on starts the wobble afresh, from no offset.
+    */
+    void setParameters (float wow, float flutter, float hiss);
+
+    bool isModulating() const noexcept       { return wowDepth > 0.0f || flutterDepth > 0.0f; }
+    bool isHissing() const noexcept          { return hissGain > 0.0f; }
+
+    /** Adds wow and flutter to a block of read-head delays, in samples, and
+        takes the change they make off the matching read speeds.
+    */
+    void modulate (float* delays, float* speeds, int numSamples) noexcept;
+
+    /** Makes a block of hiss for each channel, to be read with getHiss(). */
+    void generateHiss (int numChannels, int numSamples) noexcept;
+
+    const float* getHiss (int channel) const noexcept     { return hiss.data() + (size_t) channel * (size_t) blockSize; }
+
+private:
+    struct Phasor
+    {
+        void setFrequency (float hz, float sampleRate);
+
+        float advance() noexcept
+        {
+            auto newCos = cosine * stepCos - sine * stepSin;
+            sine = sine * stepCos + cosine * stepSin;
+            cosine = newCos;
+            return sine;
+        }
+
+        /** Pulls the phasor back onto the unit circle after rounding drift. */
+        void normalise() noexcept;
+
+        float cosine = 1.0f, sine = 0.0f, stepCos = 1.0f, stepSin = 0.0f;
+    };
+
+    struct SmoothedNoise
+    {
+        void setCutoff (float hz, float sampleRate);
+
+        float process (float input) noexcept
+        {
+            first += (input * gain - first) * coefficient;
+            value += (first - value) * coefficient;
+            return value;
+        }
+
+        float first = 0.0f, value = 0.0f, coefficient = 1.0f, gain = 1.0f;
+    };
+
+    NoiseGenerator random;
+    std::vector<float> noise, hiss;
+    int blockSize = 0;
+
+    Phasor wowCycle, flutterCycle;
+    SmoothedNoise wowDrift, flutterDrift;
+    float wowDepth = 0.0f, flutterDepth = 0.0f, hissGain = 0.0f;
+    float previousOffset = 0.0f;
+    float sampleRate = 44100.0f;
+};
@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    VarispeedInterpolator.cpp
+    Band-limited fractional reads for a read head that moves at a variable speed.
+
+  ==============================================================================
+*/
+
+#include "VarispeedInterpolator.h"
+
+static_assert (VarispeedInterpolator::numTaps == VarispeedInterpolator::getTapsForBand (VarispeedInterpolator::numBands - 1),
+               "numTaps has to cover the longest kernel");
+
+//==============================================================================
+VarispeedInterpolator::VarispeedInterpolator()
+{
+    // Band b covers read speeds around 1 + b / 2, i.e. up to 4.5x real time.
+    // The cutoff sits a little below Nyquist so the transition band doesn't fold back.
+    for (int band = 0; band < numBands; ++band)
+        bands[(size_t) band] = WindowedSincTable::getShared (getTapsForBand (band), numPhases, 0.45 / (1.0 + 0.5 * band));
+}
+
+int VarispeedInterpolator::getBandForSpeed (float speed) noexcept
+{
+    return juce::jlimit (0, numBands - 1, (int) ((speed - 1.0f) * 2.0f + 0.5f));
+}
+
+float VarispeedInterpolator::interpolate (const float* samples, float fraction, float speed) const noexcept
+{
+    // Every kernel is centred on the same read index, so shorter ones start
+    // further into the samples
+    const auto& table = *bands[(size_t) getBandForSpeed (speed)];
+    return table.interpolate (samples + tapsBefore - table.getTapsBefore(), fraction);
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    VarispeedInterpolator.h
+    Band-limited fractional reads for a read head that moves at a variable speed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WindowedSincTable.h"
+
+//==============================================================================
+/**
+    A set of windowed-sinc tables, one per cutoff band. When the read head moves
+    faster than real time the content is pitched up, so the kernel's cutoff is
+    lowered in proportion to the speed to keep it below Nyquist. The kernel
+    gets longer in the same proportion, so the transition band stays as
+    narrow, relative to the cutoff, as it is at real time.
+
+    The tables are only built once and shared between every plugin instance in
+    the process through a juce::SharedResourcePointer.
+*/
+class VarispeedInterpolator
+{
+public:
+    static constexpr int baseTaps = 8;
+    static constexpr int numPhases = 256;
+    static constexpr int numBands = 8;
+
+    /** The longest kernel, getTapsForBand (numBands - 1). */
+    static constexpr int numTaps = (baseTaps * (numBands + 1) / 2 + 3) / 4 * 4;
+
+    /** Samples before the read index that interpolate() may look at. */
+    static constexpr int tapsBefore = numTaps / 2 - 1;
+
+    VarispeedInterpolator();
+
+    /** Returns the sample at fraction past samples[tapsBefore]. The pointer must
+        give access to numTaps contiguous samples.
+    */
+    float interpolate (const float* samples, float fraction, float speed) const noexcept;
+
+    /** Picks the cutoff band for a read speed, where 1.0 is real time. */
+    static int getBandForSpeed (float speed) noexcept;
+
+    /** Band b covers speeds around 1 + b / 2, and its kernel is that many
+        times baseTaps long, rounded up to a multiple of 4.
+    */
+    static constexpr int getTapsForBand (int band) noexcept     { return (baseTaps * (2 + band) / 2 + 3) / 4 * 4; }
+
+private:
+    std::array<std::shared_ptr<const WindowedSincTable>, numBands> bands;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VarispeedInterpolator)
+};
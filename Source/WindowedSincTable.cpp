@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    WindowedSincTable.cpp
+    Precomputed windowed-sinc kernels for fractional-delay interpolation.
+
+  ==============================================================================
+*/
+
+#include "WindowedSincTable.h"
+#include "SIMDVector.h"
+
+namespace
+{
+    // Zeroth-order modified Bessel function, by its power series
+    double besselI0 (double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    double kaiserWindow (double x, double halfWidth, double beta)
+    {
+        auto ratio = x / halfWidth;
+
+        if (std::abs (ratio) >= 1.0)
+            return 0.0;
+
+        return besselI0 (beta * std::sqrt (1.0 - ratio * ratio)) / besselI0 (beta);
+    }
+}
+
+//==============================================================================
+WindowedSincTable::WindowedSincTable (int tapsToUse, int phasesToUse, double cutoff, double kaiserBeta)
+    : numTaps (tapsToUse),
+      numPhases (phasesToUse),
+      coefficients ((size_t) ((phasesToUse + 1) * tapsToUse))
+{
+    jassert (numTaps > 0 && numTaps % 4 == 0);
+    jassert (numPhases > 0);
+
+    auto halfWidth = numTaps / 2.0;
+    auto* kernel = coefficients.data();
+
+    // One extra phase so that a fraction rounding up to 1 still has a kernel
+    for (int phase = 0; phase <= numPhases; ++phase, kernel += numTaps)
+    {
+        auto fraction = (double) phase / numPhases;
+        double total = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            auto x = (double) (tap - getTapsBefore()) - fraction;
+            auto arg = juce::MathConstants<double>::pi * 2.0 * cutoff * x;
+            auto sinc = std::abs (arg) < 1.0e-9 ? 1.0 : std::sin (arg) / arg;
+            auto value = 2.0 * cutoff * sinc * kaiserWindow (x, halfWidth, kaiserBeta);
+
+            kernel[tap] = (float) value;
+            total += value;
+        }
+
+        // Unity gain at DC for every phase, so moving reads don't modulate the level
+        for (int tap = 0; tap < numTaps; ++tap)
+            kernel[tap] = (float) (kernel[tap] / total);
+    }
+}
+
+const float* WindowedSincTable::getKernel (float fraction) const noexcept
+{
+    auto phase = (int) (fraction * (float) numPhases + 0.5f);
+    return coefficients.data() + (size_t) phase * (size_t) numTaps;
+}
+
+float WindowedSincTable::interpolate (const float* samples, float fraction) const noexcept
+{
+    return dotProduct (getKernel (fraction), samples, numTaps);
+}
+
+std::shared_ptr<const WindowedSincTable> WindowedSincTable::getShared (int numTaps, int numPhases, double cutoff)
+{
+    static std::mutex lock;
+    static std::map<std::tuple<int, int, double>, std::weak_ptr<const WindowedSincTable>> tables;
+
+    const std::lock_guard<std::mutex> scopedLock (lock);
+    auto& entry = tables[{ numTaps, numPhases, cutoff }];
+
+    if (auto existing = entry.lock())
+        return existing;
+
+    auto table = std::make_shared<const WindowedSincTable> (numTaps, numPhases, cutoff);
+    entry = table;
+    return table;
+}
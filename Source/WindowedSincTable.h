@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    WindowedSincTable.h
+    Precomputed windowed-sinc kernels for fractional-delay interpolation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A polyphase table of Kaiser-windowed sinc kernels. Each phase holds the
+    numTaps coefficients needed to read a signal at one fractional offset, and
+    evaluating a read is a single SIMD dot product.
+
+    Tables are immutable once built. Use getShared() to get one that's shared by
+    every plugin instance in the process, so memory doesn't grow with the
+    number of instances.
+*/
+class WindowedSincTable
+{
+public:
+    /** numTaps must be a multiple of 4. cutoff is relative to the sample rate,
+        so 0.5 is Nyquist.
+    */
+    WindowedSincTable (int numTaps, int numPhases, double cutoff = 0.45, double kaiserBeta = 8.0);
+
+    int getNumTaps() const noexcept      { return numTaps; }
+    int getNumPhases() const noexcept    { return numPhases; }
+
+    /** Samples before the read index that a kernel covers. */
+    int getTapsBefore() const noexcept   { return numTaps / 2 - 1; }
+
+    /** Returns the kernel for the phase nearest to fraction, in [0, 1]. */
+    const float* getKernel (float fraction) const noexcept;
+
+    /** Returns the sample at fraction past samples[getTapsBefore()]. The pointer
+        must give access to getNumTaps() contiguous samples.
+    */
+    float interpolate (const float* samples, float fraction) const noexcept;
+
+    /** Returns a table for these settings, building it only if no other caller
+        currently holds one.
+    */
+    static std::shared_ptr<const WindowedSincTable> getShared (int numTaps, int numPhases, double cutoff = 0.45);
+
+private:
+    int numTaps, numPhases;
+    std::vector<float> coefficients;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WindowedSincTable)
+};